@@ -0,0 +1,103 @@
+/*
+ * File:   align.c
+ *
+ * Phase alignment of the RTC polling. Every read tells the hundredths of
+ * the RTC, so the next second starts (99 - h) * 10 .. (100 - h) * 10 ms
+ * after it. The next read is put just before the earliest possible
+ * boundary and then repeated every ALIGN_POLL ms until the seconds change;
+ * the boundary then lies between the last two reads. Once two boundaries
+ * are known that way, the length of an RTC second in ticks of the 1 ms
+ * system tick (internal oscillator, +-1 %) is tracked as well, and the
+ * first read comes ALIGN_GUARD ms before the predicted boundary:
+ *
+ *	          boundary                   boundary
+ *	read ...... |  . . . . . . . . . . r r |r
+ *	            ^ new second              ^^ old, new: 1 .. 2 ms late
+ *
+ * So the RTC is read 2 .. 3 times per second instead of every
+ * RTC_POLL_MS, and a new second is seen 1 .. 2 ms after it started.
+ * A read which is late (new second, not right after an old one) only
+ * gives the coarse 10 ms position, the next boundary is caught again by
+ * polling.
+ */
+
+#include "align.h"
+
+#define ALIGN_POLL	2		/* ms between reads around the boundary */
+#define ALIGN_GUARD	2		/* first read before the predicted boundary */
+#define ALIGN_MIN	980		/* limits of the tracked second in ticks */
+#define ALIGN_MAX	1020
+
+static tick_t al_prev;			/* previous read */
+static uint8_t al_prev_old = 0;		/* it showed the old second */
+static tick_t al_bound;			/* last boundary */
+static uint8_t al_precise = 0;		/* al_bound is within ALIGN_POLL */
+static uint16_t al_period = 1000;	/* ticks per RTC second */
+
+/*!
+ * \brief Function converts RTC hundredths into ticks
+ */
+static uint16_t align_ticks(uint16_t hs)
+{
+	return ((uint16_t)((uint32_t)hs * 10 * al_period / 1000));
+}
+
+/*!
+ * \brief Function takes one RTC read and plans the next
+ *
+ * \param t	Tick at which the read started
+ * \param hs	Hundredths register (BCD)
+ * \param rolled	The read shows a new second
+ * \return	Ms from now until the next read
+ */
+uint16_t align_read(tick_t t, uint8_t hs, uint8_t rolled)
+{
+	tick_t b, next, now = sched_ticks();
+	uint16_t d, n;
+	int16_t err;
+
+	hs = (hs >> 4) * 10 + (hs & 0x0f);
+	if (hs > 99)
+		hs = 99;
+	if (rolled && al_prev_old && (tick_t)(t - al_prev) <= ALIGN_POLL + 1) {
+		b = t - (tick_t)(t - al_prev) / 2;	/* between the two reads */
+		if (al_precise) {
+			d = b - al_bound;
+			n = (d + al_period / 2) / al_period;	/* seconds passed */
+			if (n && n < 8) {
+				err = (int16_t)(d - n * al_period) / (int16_t)n;
+				al_period += err / 4;
+				if (al_period < ALIGN_MIN)
+					al_period = ALIGN_MIN;
+				if (al_period > ALIGN_MAX)
+					al_period = ALIGN_MAX;
+			}
+		}
+		al_bound = b;
+		al_precise = 1;
+		next = b + al_period - ALIGN_GUARD;
+	} else if (rolled) {
+		al_bound = t - align_ticks(hs);		/* within 10 ms */
+		al_precise = 0;
+		next = t - align_ticks(hs + 1) + al_period;
+	} else {
+		next = t + align_ticks(99 - hs);	/* earliest by the RTC */
+		if (al_precise && (int16_t)(al_bound + al_period - ALIGN_GUARD - next) > 0)
+			next = al_bound + al_period - ALIGN_GUARD;
+		if ((int16_t)(t + ALIGN_POLL - next) > 0)
+			next = t + ALIGN_POLL;
+	}
+	al_prev = t;
+	al_prev_old = !rolled;
+	if ((int16_t)(next - now) < 1)
+		return (1);
+	return (next - now);
+}
+
+/*!
+ * \brief Length of the RTC second in system ticks
+ */
+uint16_t align_period(void)
+{
+	return (al_period);
+}
@@ -0,0 +1,18 @@
+/*
+ * File:   align.h
+ *
+ * Phase alignment of the RTC reads to the second boundary of the RTC,
+ * predicted from the hundredths register (PCF8583 register 1).
+ */
+
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include <stdint.h>
+#include "config.h"
+#include "sched.h"
+
+uint16_t align_read(tick_t, uint8_t, uint8_t);	/* Read at tick (hundredths BCD, new second ?), ms to the next read */
+uint16_t align_period(void);			/* Ticks per RTC second */
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * File:   bench.c
+ *
+ * On-target benchmarks. Time is measured by Timer1 running from Fosc/4
+ * with 1:8 prescaler (2 us per tick at 16 MHz) and shown on the LCD.
+ */
+
+#include "hal.h"
+
+#include "bench.h"
+#include "display.h"
+#include "simdelay.h"
+#include "i2c_dev.h"
+
+#define BENCH_CHARS	32		/* characters written per run */
+#define BENCH_EE_BYTES	128		/* bytes written to the EEPROM per run */
+#define BENCH_EE_PAGE	32		/* page of the 24C32 */
+
+#if LCD_BUSY_FLAG
+extern unsigned char lcd_bf;
+#endif
+#if LCD_QUEUED
+extern unsigned char lcd_q_on;
+#endif
+
+/*
+ * Timer1: Fosc/4, 1:8, 16 bit reads, running
+ */
+static void bench_timer_start(void)
+{
+	T1CON = 0b00110010;
+	TMR1H = 0;
+	TMR1L = 0;
+	T1CONbits.TMR1ON = 1;
+}
+
+/*
+ * Stop Timer1 and return elapsed time in us
+ */
+static uint16_t bench_timer_stop(void)
+{
+	uint16_t t;
+
+	T1CONbits.TMR1ON = 0;
+	t = TMR1L;			/* TMR1H is latched by reading TMR1L */
+	t |= (uint16_t)TMR1H << 8;
+	return (uint16_t)((uint32_t)t * 32 / (_XTAL_FREQ / 1000000UL));
+}
+
+/*
+ * Print unsigned number with 5 digits
+ */
+static void bench_putu(uint16_t n)
+{
+	uint16_t d;
+
+	for (d = 10000; d; d /= 10)
+		lcd_putchar('0' + (n / d) % 10);
+}
+
+/*
+ * Write BENCH_CHARS characters, return time in us until the LCD has them
+ * (the queued output is drained inside the measurement)
+ */
+static uint16_t bench_lcd_run(void)
+{
+	uint8_t i;
+
+	lcd_goto(0);
+	lcd_sync();
+	bench_timer_start();
+	for (i = 0; i < BENCH_CHARS; i++)
+		lcd_putchar('0' + (i & 7));
+	lcd_sync();
+	return bench_timer_stop();
+}
+
+/*
+ * Compare BENCH_CHARS character writes with fixed delays and with busy
+ * flag polling, both written directly (the queue would clock either at
+ * its tick), result in us:
+ *	dly 01234us
+ *	bf  00567us
+ */
+void bench_lcd(void)
+{
+	uint16_t tdly, tbf = 0;
+#if LCD_BUSY_FLAG
+	unsigned char bf;
+#endif
+#if LCD_QUEUED
+	unsigned char q;
+#endif
+
+	lcd_sync();			// init sequence out of the way
+#if LCD_QUEUED
+	q = lcd_q_on;
+	lcd_q_on = 0;
+#endif
+#if LCD_BUSY_FLAG
+	bf = lcd_bf;
+
+	lcd_bf = 0;
+	tdly = bench_lcd_run();
+	lcd_bf = bf;
+	if (lcd_bf)
+		tbf = bench_lcd_run();
+#else
+	tdly = bench_lcd_run();
+#endif
+#if LCD_QUEUED
+	lcd_q_on = q;
+#endif
+	lcd_clear();
+	lcd_goto(0);
+	lcd_puts("dly ");
+	bench_putu(tdly);
+	lcd_puts("us");
+	lcd_goto(LCD_LINE2);
+	lcd_puts("bf  ");
+	bench_putu(tbf);
+	lcd_puts("us");
+	DelayMs(3000);
+	lcd_clear();
+}
+
+#if BENCH_EEPROM
+static uint8_t bench_buf[BENCH_EE_BYTES];
+
+/*
+ * Compare a write of BENCH_EE_BYTES bytes to the 24C32 page by page with
+ * the fixed 5 ms write cycle and streamed with ACK polling (incl. the
+ * last write cycle), then read it back. Result in us:
+ *	dly 23456us
+ *	ack 15678us ok
+ */
+void bench_eeprom(void)
+{
+	i2c_dev_t fixed = I2C_DEV(0x52, I2C_SPEED_FAST, 2);
+	i2c_dev_t polled = I2C_DEV_MEM(0x52, I2C_SPEED_FAST, 2, BENCH_EE_PAGE);
+	uint16_t tdly, tack;
+	uint8_t i, ok = 1;
+
+	for (i = 0; i < BENCH_EE_BYTES; i++)
+		bench_buf[i] = i;
+	bench_timer_start();
+	for (i = 0; i < BENCH_EE_BYTES; i += BENCH_EE_PAGE) {
+		ok &= i2c_dev_write(&fixed, i, &bench_buf[i], BENCH_EE_PAGE);
+		DelayMs(5);
+	}
+	tdly = bench_timer_stop();
+
+	for (i = 0; i < BENCH_EE_BYTES; i++)
+		bench_buf[i] = ~i;
+	bench_timer_start();
+	ok &= i2c_dev_write_block(&polled, 0, bench_buf, BENCH_EE_BYTES);
+	ok &= i2c_dev_ready(&polled);
+	tack = bench_timer_stop();
+
+	ok &= i2c_dev_read(&polled, 0, bench_buf, BENCH_EE_BYTES);
+	for (i = 0; i < BENCH_EE_BYTES; i++)
+		if (bench_buf[i] != (uint8_t)~i)
+			ok = 0;
+	lcd_clear();
+	lcd_goto(0);
+	lcd_puts("dly ");
+	bench_putu(tdly);
+	lcd_puts("us");
+	lcd_goto(LCD_LINE2);
+	lcd_puts("ack ");
+	bench_putu(tack);
+	lcd_puts(ok ? "us ok" : "us err");
+	DelayMs(3000);
+	lcd_clear();
+}
+#endif
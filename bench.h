@@ -0,0 +1,16 @@
+/*
+ * File:   bench.h
+ *
+ * On-target benchmarks, results are shown on the LCD.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "config.h"
+
+void bench_lcd(void);			/* LCD write: fixed delays vs. busy flag */
+void bench_eeprom(void);		/* 24C32 write: fixed write cycles vs. ACK polling */
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * File:   buttons.c
+ *
+ * Button driver. The INTx edge interrupts are the only cost while no key
+ * is touched: the first falling edge disables them (contacts bounce) and
+ * activates the debouncer, which runs from the 1 ms tick interrupt until
+ * every key is released and stable again.
+ *
+ * Every key has its own state machine:
+ *
+ *   UP --(low for BTN_DEBOUNCE_MS)--> DOWN, PRESS
+ *   DOWN --(BTN_LONG_MS)--> LONG, then REPEAT every BTN_REPEAT_MS
+ *   DOWN --(high for BTN_DEBOUNCE_MS)--> UP, RELEASE
+ *
+ * PORTB has interrupt-on-change on RB4..RB7 only, so the buttons on
+ * RB0..RB2 use the INT0..INT2 edge interrupts instead.
+ */
+
+#include "hal.h"
+
+#include "buttons.h"
+
+static uint8_t btn_task = SCHED_NONE;	/* task triggered by new events */
+static volatile uint8_t btn_active = 0;	/* debouncer running */
+static uint8_t btn_state = 0;		/* debounced state, bit per key */
+static uint8_t btn_cnt[BTN_KEYS];	/* ms the raw level differs from state */
+static uint16_t btn_held[BTN_KEYS];	/* ms the key is down */
+
+static btn_event_t btn_q[BTN_QUEUE];
+static volatile uint8_t btn_q_head = 0;
+static volatile uint8_t btn_q_count = 0;
+
+/*!
+ * \brief Raw state of the buttons, pressed button reads 0
+ */
+static uint8_t btn_raw(void)
+{
+	return (~hal_port(B) & 0b00000111);
+}
+
+/*!
+ * \brief Arm INT0..INT2 for the next falling edge
+ */
+static void btn_arm(void)
+{
+	INTCONbits.INT0IF = 0;
+	INTCON3bits.INT1IF = 0;
+	INTCON3bits.INT2IF = 0;
+	INTCONbits.INT0IE = 1;
+	INTCON3bits.INT1IE = 1;
+	INTCON3bits.INT2IE = 1;
+}
+
+/*!
+ * \brief Function configures RB0..RB2 and the edge interrupts
+ *
+ * \param task	Scheduler task triggered when an event is queued
+ */
+void btn_init(uint8_t task)
+{
+	btn_task = task;
+	hal_tris_or(B, 0b00000111);
+	WPUB |= 0b00000111;		/* weak pull-ups */
+	INTCON2bits.RBPU = 0;
+	INTCON2bits.INTEDG0 = 0;	/* falling edge = press */
+	INTCON2bits.INTEDG1 = 0;
+	INTCON2bits.INTEDG2 = 0;
+	btn_arm();
+	if (btn_raw())			/* held during reset */
+		btn_active = 1;
+}
+
+/*!
+ * \brief Put an event into the queue (interrupt context), oldest is lost when full
+ */
+static void btn_put(uint8_t key, uint8_t type)
+{
+	btn_event_t *e;
+
+	if (btn_q_count == BTN_QUEUE) {
+		btn_q_head = (btn_q_head + 1) % BTN_QUEUE;
+		btn_q_count--;
+	}
+	e = &btn_q[(btn_q_head + btn_q_count) % BTN_QUEUE];
+	e->key = key;
+	e->type = type;
+	e->time = sched_ticks();
+	btn_q_count++;
+	sched_trigger(btn_task);
+}
+
+/*!
+ * \brief INT0..INT2 handler: start the debouncer
+ */
+void btn_isr(void)
+{
+	if ((INTCONbits.INT0IE && INTCONbits.INT0IF) ||
+	    (INTCON3bits.INT1IE && INTCON3bits.INT1IF) ||
+	    (INTCON3bits.INT2IE && INTCON3bits.INT2IF)) {
+		INTCONbits.INT0IE = 0;	/* bounces are the debouncer's job */
+		INTCON3bits.INT1IE = 0;
+		INTCON3bits.INT2IE = 0;
+		btn_active = 1;
+	}
+}
+
+/*!
+ * \brief Debouncer, one step per 1 ms tick while any key is active
+ */
+void btn_tick(void)
+{
+	uint8_t i, raw, bit;
+
+	if (!btn_active)
+		return;
+	raw = btn_raw();
+	for (i = 0, bit = 1; i < BTN_KEYS; i++, bit <<= 1) {
+		if ((raw ^ btn_state) & bit) {
+			if (++btn_cnt[i] < BTN_DEBOUNCE_MS)
+				continue;
+			btn_cnt[i] = 0;
+			btn_state ^= bit;
+			btn_held[i] = 0;
+			btn_put(i, (btn_state & bit) ? BTN_PRESS : BTN_RELEASE);
+		} else {
+			btn_cnt[i] = 0;
+			if (!(btn_state & bit))
+				continue;
+			btn_held[i]++;
+			if (btn_held[i] == BTN_LONG_MS) {
+				btn_put(i, BTN_LONG);
+			} else if (btn_held[i] == BTN_LONG_MS + BTN_REPEAT_MS) {
+				btn_held[i] = BTN_LONG_MS;
+				btn_put(i, BTN_REPEAT);
+			}
+		}
+	}
+	if (!raw && !btn_state) {	/* all released and stable */
+		btn_active = 0;
+		btn_arm();
+		if (btn_raw())		/* pressed while arming, edge may be lost */
+			btn_active = 1;
+	}
+}
+
+/*!
+ * \brief Function takes the oldest event from the queue
+ *
+ * \param *e	Space for the event
+ * \return 1	Event returned
+ * \return 0	Queue is empty
+ */
+uint8_t btn_get(btn_event_t *e)
+{
+	uint8_t ok = 0;
+
+	hal_irq_off();
+	if (btn_q_count) {
+		*e = btn_q[btn_q_head];
+		btn_q_head = (btn_q_head + 1) % BTN_QUEUE;
+		btn_q_count--;
+		ok = 1;
+	}
+	hal_irq_on();
+	return (ok);
+}
+
+/*!
+ * \brief Debounced state of the buttons, bit 0 = BTN1
+ */
+uint8_t btn_down(void)
+{
+	return (btn_state);
+}
+
+/*!
+ * \brief Is the debouncer stopped (no tick needed) ?
+ */
+uint8_t btn_idle(void)
+{
+	return (!btn_active);
+}
@@ -0,0 +1,37 @@
+/*
+ * File:   buttons.h
+ *
+ * Interrupt driven buttons: BTN1..BTN3 on RB0..RB2 (INT0..INT2).
+ * A falling edge starts the debouncer on the system tick, which puts
+ * press/release/long-press/repeat events into a queue and goes back to
+ * sleep when all buttons are released.
+ */
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+#include "config.h"
+#include "sched.h"
+
+#define BTN_KEYS	3		/* BTN1 .. BTN3 */
+
+#define BTN_PRESS	0		/* button went down */
+#define BTN_RELEASE	1		/* button went up */
+#define BTN_LONG	2		/* held for BTN_LONG_MS */
+#define BTN_REPEAT	3		/* still held, every BTN_REPEAT_MS */
+
+typedef struct {
+	uint8_t key;			/* 0 = BTN1 .. 2 = BTN3 */
+	uint8_t type;			/* BTN_xxx */
+	tick_t time;			/* system tick of the event */
+} btn_event_t;
+
+void btn_init(uint8_t);			/* Set up the pins, task to trigger on events */
+uint8_t btn_get(btn_event_t *);		/* Take the oldest event, 0 if there is none */
+uint8_t btn_down(void);			/* Debounced state, bit 0 = BTN1 */
+uint8_t btn_idle(void);			/* Is the debouncer stopped ? */
+void btn_isr(void);			/* INT0..INT2 interrupt handler */
+void btn_tick(void);			/* Debouncer, called on every system tick */
+
+#endif
@@ -0,0 +1,327 @@
+/*
+ * File:   config.h
+ *
+ * Compile-time configuration of the clock firmware. Every option can also
+ * be overridden from the compiler command line (-D<option>=<value>).
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/*
+ * Clock of the CPU (internal oscillator at full speed, see init())
+ * 0 = 16 MHz
+ * 1 = 64 MHz, 4x PLL enabled
+ */
+#ifndef FOSC_PLL
+#define FOSC_PLL            0
+#endif
+
+/*
+ * CPU clock frequency in Hz
+ */
+#ifndef _XTAL_FREQ
+#if FOSC_PLL
+#define _XTAL_FREQ          64000000UL
+#else
+#define _XTAL_FREQ          16000000UL
+#endif
+#endif
+
+/*
+ * I2C backend used for the RTC bus (RD0 = SCL, RD1 = SDA)
+ * 0 = bit-banged driver (i2c2.c)
+ * 1 = MSSP2 hardware peripheral (i2c_mssp.c), RD0/RD1 are SCL2/SDA2
+ */
+#ifndef I2C_USE_MSSP
+#define I2C_USE_MSSP        1
+#endif
+
+/*
+ * SCL frequency of the MSSP backend in Hz, PCF8583 is a 100 kHz device
+ */
+#ifndef I2C_MSSP_SPEED
+#define I2C_MSSP_SPEED      100000UL
+#endif
+
+/*
+ * Longest time in us the MSSP backend waits for one bus event (START,
+ * byte, ACK, STOP) including clock stretching, then the transaction fails
+ */
+#ifndef I2C_MSSP_TIMEOUT_US
+#define I2C_MSSP_TIMEOUT_US 1000
+#endif
+
+/*
+ * SCL frequency in Hz of the bit-banged backend for I2C_SPEED_FAST devices
+ * 100000 = every device in standard mode
+ * 400000 = fast mode (the loop overhead keeps it lower at 16 MHz)
+ */
+#ifndef I2C_SOFT_SPEED
+#define I2C_SOFT_SPEED      400000UL
+#endif
+
+/*
+ * Longest time in us a slave may stretch SCL in the bit-banged backend,
+ * then the transaction fails and the bus is recovered
+ */
+#ifndef I2C_SOFT_TIMEOUT_US
+#define I2C_SOFT_TIMEOUT_US 500
+#endif
+
+/*
+ * Longest write cycle in ms of a memory device (24Cxx: 5 ms), ACK polling
+ * of i2c_dev.c gives up after it
+ */
+#ifndef I2C_WRITE_CYCLE_MS
+#define I2C_WRITE_CYCLE_MS  5
+#endif
+
+/*
+ * Non-blocking RTC access through the interrupt driven transaction engine
+ * (i2c_async.c); with the bit-banged backend the engine runs synchronously
+ * 0 = getTime()/setTime() block on the bus
+ * 1 = getTime() queues the read and the main loop continues
+ */
+#ifndef I2C_ASYNC
+#define I2C_ASYNC           1
+#endif
+
+/*
+ * Number of transactions which can wait in the queue of the engine
+ */
+#ifndef I2C_ASYNC_QUEUE
+#define I2C_ASYNC_QUEUE     4
+#endif
+
+/*
+ * Event driven RTC reads, requires the RTC INT output wired to RB5
+ * 0 = main loop reads the RTC on every iteration
+ * 1 = RTC is read once per second on the falling edge of its 1 Hz output
+ */
+#ifndef RTC_EVENT_DRIVEN
+#define RTC_EVENT_DRIVEN    0
+#endif
+
+/*
+ * LCD write timing (display.c), RW must be connected to RC5
+ * 0 = fixed worst case delay after every byte
+ * 1 = poll the busy flag, falls back to the delays if it never clears
+ */
+#ifndef LCD_BUSY_FLAG
+#define LCD_BUSY_FLAG       1
+#endif
+
+/*
+ * Number of busy flag reads before the LCD is declared missing (~4 ms)
+ */
+#ifndef LCD_BF_TIMEOUT
+#define LCD_BF_TIMEOUT      500
+#endif
+
+/*
+ * Benchmark of LCD character writes shown after power on (bench.c)
+ */
+#ifndef BENCH_LCD
+#define BENCH_LCD           0
+#endif
+
+/*
+ * Benchmark of a paged write to a 24C32 EEPROM at 0x52 (A1 pin high),
+ * fixed 5 ms write cycles vs. ACK polling, shown after power on (bench.c)
+ */
+#ifndef BENCH_EEPROM
+#define BENCH_EEPROM        0
+#endif
+
+/*
+ * Queued LCD output (display.c), Timer2 interrupt clocks one nibble per
+ * 50 us tick so rendering never waits for the controller
+ * 0 = lcd_write() writes directly
+ * 1 = lcd_write() only queues the byte, lcd_sync() waits for the queue
+ */
+#ifndef LCD_QUEUED
+#define LCD_QUEUED          1
+#endif
+
+/*
+ * Size of the LCD output queue in bytes (a full 2x16 redraw is 36 bytes)
+ */
+#ifndef LCD_QUEUE
+#define LCD_QUEUE           40
+#endif
+
+/*
+ * Supply of the LCD panel, selects the values of the init sequence
+ * 0 = 5 V, booster off
+ * 1 = 3.3 V, booster on
+ */
+#ifndef LCD_3V3
+#define LCD_3V3             0
+#endif
+
+/*
+ * Period of RTC reads in ms when RTC_EVENT_DRIVEN is 0 and RTC_ALIGN
+ * is not used
+ */
+#ifndef RTC_POLL_MS
+#define RTC_POLL_MS         20
+#endif
+
+/*
+ * Polled RTC reads aligned to the RTC second (align.c), used when
+ * RTC_EVENT_DRIVEN and LOCAL_TIME are 0
+ * 0 = read every RTC_POLL_MS
+ * 1 = predict the next second from the hundredths register, read the
+ *     RTC only around it (2 .. 3 reads per second) and send the frame
+ *     rendered in advance as soon as the new second is seen
+ */
+#ifndef RTC_ALIGN
+#define RTC_ALIGN           1
+#endif
+
+/*
+ * Warm start: after a reset the time of the battery backed RTC is kept
+ * when it answers, its registers hold a valid running time and its RAM
+ * the signature of a previous cold start (see rtcResume()).
+ * 0 = RTC is set to 12:00:00 on every boot
+ */
+#ifndef RTC_WARM_START
+#define RTC_WARM_START      1
+#endif
+
+/*
+ * Shadow of the RTC registers (rtc_cache.c)
+ * 0 = every getTime()/setTime() goes to the bus
+ * 1 = reads within the second of the latest read are served from the
+ *     shadow, setTime() writes only the registers which changed
+ */
+#ifndef RTC_CACHE
+#define RTC_CACHE           1
+#endif
+
+/*
+ * State and event log in the battery backed RAM of the RTC (rtc_ram.c)
+ * 0 = the RAM only holds the boot signature
+ * 1 = the display mode is kept in the RAM at once and restored by a warm
+ *     start, time set and clock stop are logged (debug page, BTN1)
+ */
+#ifndef RTC_RAM
+#define RTC_RAM             1
+#endif
+
+/*
+ * Settings in the data EEPROM (settings.c): display mode and the time of
+ * a cold start survive a reset
+ * 0 = every boot starts in the regular mode at 12:00:00
+ * 1 = settings are loaded at boot and written SETTINGS_DELAY_MS after
+ *     the last change
+ */
+#ifndef SETTINGS
+#define SETTINGS            1
+#endif
+
+/*
+ * Record slots of the settings (8 bytes each) from EEPROM address
+ * SETTINGS_BASE, more slots spread the wear over more bytes
+ */
+#ifndef SETTINGS_SLOTS
+#define SETTINGS_SLOTS      64
+#endif
+#ifndef SETTINGS_BASE
+#define SETTINGS_BASE       0
+#endif
+
+/*
+ * Quiet time in ms after a change of the settings before they are
+ * written, key presses in between cost no extra record
+ */
+#ifndef SETTINGS_DELAY_MS
+#define SETTINGS_DELAY_MS   5000
+#endif
+
+/*
+ * Size of the task table of the scheduler (sched.c)
+ */
+#ifndef SCHED_TASKS
+#define SCHED_TASKS         8
+#endif
+
+/*
+ * Buttons (buttons.c): debounce time, long press and auto-repeat in ms,
+ * size of the event queue
+ */
+#ifndef BTN_DEBOUNCE_MS
+#define BTN_DEBOUNCE_MS     20
+#endif
+#ifndef BTN_LONG_MS
+#define BTN_LONG_MS         800
+#endif
+#ifndef BTN_REPEAT_MS
+#define BTN_REPEAT_MS       150
+#endif
+#ifndef BTN_QUEUE
+#define BTN_QUEUE           8
+#endif
+
+/*
+ * Power management (power.c): LOW_POWER lets the CPU enter SLEEP when no
+ * timed task is pending (needs RTC_EVENT_DRIVEN for the 1 Hz wake-up) and
+ * switches the LCD off after POWER_LCD_OFF_S seconds without a key press
+ */
+#ifndef LOW_POWER
+#define LOW_POWER           0
+#endif
+#ifndef POWER_LCD_OFF_S
+#define POWER_LCD_OFF_S     30
+#endif
+
+/*
+ * Local timekeeping (timekeep.c): Timer1 keeps the time and the RTC is
+ * read only every TIME_RESYNC_MIN minutes; Timer1 runs from the 32.768 kHz
+ * SOSC crystal if LOCAL_TIME_SOSC is set (RC0/RC1, see timekeep.c), from
+ * Fosc otherwise. TIME_LOG drift measurements are kept.
+ */
+#ifndef LOCAL_TIME
+#define LOCAL_TIME          0
+#endif
+#ifndef LOCAL_TIME_SOSC
+#define LOCAL_TIME_SOSC     0
+#endif
+#ifndef TIME_RESYNC_MIN
+#define TIME_RESYNC_MIN     20
+#endif
+#ifndef TIME_LOG
+#define TIME_LOG            8
+#endif
+
+/*
+ * Cycle profiler (prof.c): PROF_BEGIN/PROF_END probes count Timer3 ticks
+ * (Fosc/4 with the prescaler 1:2^PROFILE_PS) of getTime(), display(),
+ * lcd_write() and takeKey(); the table is shown on the debug pages and
+ * with PROFILE_UART also sent on EUSART2 (TX2 = RD6, PROFILE_BAUD 8N1)
+ */
+#ifndef PROFILE
+#define PROFILE             0
+#endif
+#ifndef PROFILE_PS
+#define PROFILE_PS          3
+#endif
+#ifndef PROFILE_UART
+#define PROFILE_UART        0
+#endif
+#ifndef PROFILE_BAUD
+#define PROFILE_BAUD        9600UL
+#endif
+
+/*
+ * Latency marker for an oscilloscope (display.c): RA0 goes high with the
+ * first changed character of a frame and low once its last byte is in
+ * the LCD. Button or RTC INT edge to the falling edge is the end-to-end
+ * latency; dist/host/clock -b measures the same on the host.
+ */
+#ifndef BENCH_MARK
+#define BENCH_MARK          0
+#endif
+
+#endif
@@ -16,12 +16,13 @@
  *
  */
  
-#include <pic18.h>
+#include "hal.h"
 //#include "delay18.h"
 //#include "delays.h"
 #include "simdelay.h"
- 
-#define DelayUs(x) {_delay(x);}
+#include "display.h"
+#include "config.h"
+#include "prof.h"
  
 //static bit LCD_RS	@ ((unsigned)&PORTA*8+3);	// Register select
 //#static bit LCD_EN	@ ((unsigned)&PORTA*8+5);	// Enable
@@ -33,28 +34,331 @@
  
 volatile static int LCD_RS_flag;
  
+/*
+ * Shadow frame buffer. lcd_fb holds the wanted screen, lcd_shadow what the
+ * LCD really shows (kept up to date by lcd_putchar/lcd_goto/lcd_clear) and
+ * lcd_cursor the DDRAM address the LCD writes next (0xff = unknown).
+ * Positions count LCD_LINE2 per row, the LCD's rows start at
+ * LCD_DDRAM_ROW and hold LCD_DDRAM_COLS cells.
+ */
+#define LCD_DDRAM_ROW	0x40	// DDRAM address of the 2nd row
+#define LCD_DDRAM_COLS	40	// cells per row, the address counter skips the rest
+
+static char lcd_fb[LCD_ROWS][LCD_COLS];
+static char lcd_shadow[LCD_ROWS][LCD_COLS];
+static unsigned char lcd_fb_pos;
+static unsigned char lcd_cursor = 0xff;
+ 
 //#define	LCD_STROBE	((LCD_EN = 1),(LCD_EN=1),(LCD_EN=0))
 //
-#define LCD_STROBE() { DelayUs(2); LATC |=  0x10; DelayUs(2); LATC = LATC & 0x0F; DelayUs(2); }
-#define LCD_RS(x) {if(x == 1) LATC |=  0x40; else LATC &=  0x0F;}
+#define LCD_STROBE() { DelayUs(2); hal_lat_or(C, 0x10); DelayUs(2); hal_lat_and(C, 0x0F); DelayUs(2); }
+#define LCD_RS(x) {if(x == 1) hal_lat_or(C, 0x40); else hal_lat_and(C, 0x0F);}
+#define LCD_EN_CY	((450UL * (_XTAL_FREQ / 4000UL) + 999999UL) / 1000000UL)	// EN high >= 450 ns, in Tcy
+ 
+/*
+ * Values of the init sequence which differ between the panels (LCD_3V3)
+ */
+#if LCD_3V3
+#define LCD_OSC		0x1F	// bias 1/4, int osc freq
+#define LCD_POWER	0x54	// booster on, contrast C5..4
+#define LCD_FOLLOWER	0x6E	// follower on, amplifier ratio 6
+#define LCD_DCTL	0x0F	// display on, cursor on, blink on
+#else
+#define LCD_OSC		0x1D	// bias 1/4, int osc freq
+#define LCD_POWER	0x50	// booster off, contrast C5..4
+#define LCD_FOLLOWER	0x6C	// follower on, amplifier ratio 4
+#define LCD_DCTL	0x0E	// display on, cursor on
+#endif
+#define LCD_SETTLE_MS	204	// follower on to display on, 200 ms + 2 % osc
+ 
+#if BENCH_MARK
+#define LCD_MARK(x)	hal_pin_write(A, 0, x)	// RA0: frame on its way to the LCD
+#else
+#define LCD_MARK(x)
+#endif
  
 //#define LCD_CHK() {LCD_RW = 1; LCD_RS = 0;  DelayUs(2); LCD_STROBE() ; DelayUs(2); LCD_STROBE();LCD_RW = 0;DelayUs(2)}
  
+#if LCD_BUSY_FLAG
+/*
+ * 1 = wait for the busy flag, 0 = fixed delays. Enabled once the LCD is in
+ * 4 bit mode, disabled for good when the flag does not clear in time
+ * (no display, RW not connected), so a missing LCD cannot hang the clock.
+ */
+unsigned char lcd_bf = 0;
+ 
+/*
+ * read the busy flag once, 1 = controller busy (cycle delays only, the
+ * Timer2 interrupt uses it too)
+ */
+static unsigned char lcd_bf_read(void)
+{
+	unsigned char st;
+
+	hal_tris_or(C, 0x0F);		// data lines are driven by the LCD
+	hal_lat_write(C, 0x20);		// RW = 1, RS = 0: read busy flag and address
+	hal_lat_or(C, 0x10);		// EN = 1, high nibble: BF + AC6..4
+	hal_delay_cy(LCD_EN_CY);
+	st = hal_port(C);
+	hal_lat_and(C, ~0x10);
+	hal_delay_cy(LCD_EN_CY);
+	hal_lat_or(C, 0x10);		// low nibble (AC3..0) must be clocked out too
+	hal_delay_cy(LCD_EN_CY);
+	hal_lat_and(C, ~0x10);
+	hal_lat_write(C, 0);		// RW = 0
+	hal_tris_and(C, 0xF0);
+	return ((st & 0x08) != 0);
+}
+ 
+/*
+ * read the busy flag until the controller is ready, 0 on timeout
+ */
+static unsigned char lcd_busy_wait(void)
+{
+	unsigned int n = LCD_BF_TIMEOUT;
+ 
+	while (lcd_bf_read()) {
+		if (!--n)
+			return (0);
+		DelayUs(6);		// ~8 us per read, LCD_BF_TIMEOUT reads ~4 ms
+	}
+	return (1);
+}
+#endif
+ 
+#if LCD_QUEUED
+/*
+ * Output queue drained by the Timer2 interrupt, one nibble per tick.
+ * Each entry is the byte and its flags (RS in the LATC bit position and
+ * LCD_Q_SLOW for commands that run for ~1.5 ms). With the busy flag the
+ * interrupt reads it before each entry and the slow commands end as soon
+ * as the controller is ready, else they wait LCD_SLOW_TICKS.
+ */
+#define LCD_Q_SLOW	0x01
+#define LCD_Q_SETTLE	0x02		// wait LCD_SETTLE_MS before the entry
+#define LCD_Q_RS	0x40
+#define LCD_TICK_US	50		// tick period, longer than any fast command
+#define LCD_SLOW_TICKS	(2000 / LCD_TICK_US)
+#define LCD_BF_TICKS	(4000 / LCD_TICK_US)	// busy flag set longer: no flag
+#define LCD_SETTLE_TICKS	200		// lcd_q_wait per settle round
+#define LCD_SETTLE_ROUNDS	((LCD_SETTLE_MS * 1000UL / LCD_TICK_US + LCD_SETTLE_TICKS - 1) / LCD_SETTLE_TICKS)	// rounded up
+ 
+#if _XTAL_FREQ > 16000000UL
+#define LCD_T2CON	0b00000101	// 1:4 prescaler, timer on
+#define LCD_T2PS	4
+#else
+#define LCD_T2CON	0b00000100	// 1:1 prescaler, timer on
+#define LCD_T2PS	1
+#endif
+#define LCD_PR2		(_XTAL_FREQ / 4 / LCD_T2PS / (1000000UL / LCD_TICK_US) - 1)
+ 
+static unsigned char lcd_q_data[LCD_QUEUE];
+static unsigned char lcd_q_flags[LCD_QUEUE];
+static volatile unsigned char lcd_q_head;	// next entry for the ISR
+static unsigned char lcd_q_tail;		// next free entry
+static volatile unsigned char lcd_q_count;
+static volatile unsigned char lcd_q_phase;	// 1 = low nibble pending
+static volatile unsigned char lcd_q_wait;	// ticks until controller is ready
+unsigned char lcd_q_on = 0;			// queue in use (4 bit mode reached)
+static unsigned char lcd_q_settle;		// settle rounds left
+#if LCD_BUSY_FLAG
+static unsigned char lcd_q_bf;			// ticks the busy flag was set
+#endif
+ 
+/*
+ * Timer2 interrupt: clock one nibble of the head entry to the LCD
+ */
+void lcd_isr(void)
+{
+	unsigned char c, f;
+ 
+	if (!PIE1bits.TMR2IE || !PIR1bits.TMR2IF)
+		return;
+	PIR1bits.TMR2IF = 0;
+ 
+	if (lcd_q_wait) {
+		lcd_q_wait--;
+		return;
+	}
+	if (!lcd_q_count) {
+		PIE1bits.TMR2IE = 0;		// idle: no more ticks
+		T2CONbits.TMR2ON = 0;
+		return;
+	}
+	c = lcd_q_data[lcd_q_head];
+	f = lcd_q_flags[lcd_q_head];
+	if (!lcd_q_phase && (f & LCD_Q_SETTLE) && lcd_q_settle) {
+		lcd_q_settle--;			// follower circuit not stable yet
+		lcd_q_wait = LCD_SETTLE_TICKS;
+		return;
+	}
+#if LCD_BUSY_FLAG
+	if (!lcd_q_phase && lcd_bf) {
+		if (lcd_bf_read() && ++lcd_q_bf < LCD_BF_TICKS)
+			return;			// previous command still runs
+		if (lcd_q_bf >= LCD_BF_TICKS)
+			lcd_bf = 0;		// no busy flag, use the ticks
+		lcd_q_bf = 0;
+	}
+#endif
+	if (!lcd_q_phase) {
+		hal_lat_write(C, (c >> 4) | (f & LCD_Q_RS));
+		lcd_q_phase = 1;
+	} else {
+		hal_lat_write(C, (c & 0x0F) | (f & LCD_Q_RS));
+		lcd_q_phase = 0;
+#if LCD_BUSY_FLAG
+		if ((f & LCD_Q_SLOW) && !lcd_bf)
+#else
+		if (f & LCD_Q_SLOW)
+#endif
+			lcd_q_wait = LCD_SLOW_TICKS;
+		lcd_q_head = (lcd_q_head + 1) % LCD_QUEUE;
+		if (!--lcd_q_count)
+			LCD_MARK(0);			// frame is in the LCD
+	}
+	hal_lat_or(C, 0x10);				// EN pulse, >= 450 ns
+	hal_delay_cy(LCD_EN_CY);
+	hal_lat_and(C, 0x4F);
+}
+ 
+/*
+ * put a byte into the output queue, waits only while the queue is full
+ */
+static void lcd_q_put(unsigned char c, unsigned char f)
+{
+	while (lcd_q_count == LCD_QUEUE)
+		hal_poll();
+	lcd_q_data[lcd_q_tail] = c;
+	lcd_q_flags[lcd_q_tail] = f;
+	lcd_q_tail = (lcd_q_tail + 1) % LCD_QUEUE;
+	PIE1bits.TMR2IE = 0;
+	if (f & LCD_Q_SETTLE)
+		lcd_q_settle = LCD_SETTLE_ROUNDS;
+	lcd_q_count++;
+	if (!T2CONbits.TMR2ON) {
+		TMR2 = 0;
+		PIR1bits.TMR2IF = 0;
+		T2CONbits.TMR2ON = 1;
+	}
+	PIE1bits.TMR2IE = 1;
+}
+ 
+/*
+ * Timer2 ticks every LCD_TICK_US, interrupt enabled only with data queued
+ */
+static void lcd_q_start(void)
+{
+	T2CON = LCD_T2CON & ~0x04;
+	PR2 = LCD_PR2;
+	lcd_q_head = lcd_q_tail = lcd_q_count = 0;
+	lcd_q_phase = lcd_q_wait = 0;
+#if LCD_BUSY_FLAG
+	lcd_q_bf = 0;
+#endif
+	lcd_q_on = 1;
+}
+#endif
+ 
+/*
+ * wait until everything written so far is in the LCD and executed
+ */
+void lcd_sync(void)
+{
+#if LCD_QUEUED
+	while (lcd_busy())
+		hal_poll();
+#endif
+#if LCD_BUSY_FLAG
+	if (lcd_bf && !lcd_busy_wait())		// e.g. a clear still runs
+		lcd_bf = 0;
+#endif
+}
+ 
+/*
+ * is any output still on its way to the LCD ? The queue stops one tick
+ * after its last entry, when that command has finished.
+ */
+unsigned char lcd_busy(void)
+{
+#if LCD_QUEUED
+	return (lcd_q_count || lcd_q_phase || lcd_q_wait || PIE1bits.TMR2IE);
+#else
+	return (0);
+#endif
+}
+ 
 /* 
  * write a byte to the LCD in 4 bit mode 
  */
 void lcd_write(unsigned char c)
 {
-        LATC = (c >> 4);
+        PROF_BEGIN(PROF_LCD_WRITE);
+#if LCD_QUEUED
+        if (lcd_q_on) {
+                if (LCD_RS_flag)
+                        lcd_q_put(c, LCD_Q_RS);
+                else		// clear and home are the slow commands
+                        lcd_q_put(c, c < 4 ? LCD_Q_SLOW : 0);
+                PROF_END(PROF_LCD_WRITE);
+                return;
+        }
+#endif
+#if LCD_BUSY_FLAG
+        if (lcd_bf && !lcd_busy_wait()) {
+                lcd_bf = 0;		// no busy flag, use the delays
+                DelayMs(2);		// longest command, just in case
+        }
+#endif
+        hal_lat_write(C, (c >> 4));
         LCD_RS(LCD_RS_flag);
         LCD_STROBE();
         DelayUs(2);
  
-        LATC = c & 0xF;
+        hal_lat_write(C, c & 0xF);
         LCD_RS(LCD_RS_flag);
         LCD_STROBE();
  
+#if LCD_BUSY_FLAG
+        if (lcd_bf) {
+                PROF_END(PROF_LCD_WRITE);
+                return;			// next write waits for busy flag
+        }
+#endif
         DelayUs(50);
+        PROF_END(PROF_LCD_WRITE);
+}
+ 
+/*
+ * Shadow: LCD was cleared, cursor at home
+ */
+static void lcd_shadow_clear(void)
+{
+	unsigned char r, c;
+
+	for (r = 0; r < LCD_ROWS; r++)
+		for (c = 0; c < LCD_COLS; c++)
+			lcd_shadow[r][c] = ' ';
+	lcd_cursor = 0;
+}
+ 
+/*
+ * Shadow: character s written at the cursor, cursor moves right
+ */
+static void lcd_shadow_put(char s)
+{
+	unsigned char r, c;
+
+	if (lcd_cursor == 0xff)
+		return;
+	r = lcd_cursor / LCD_DDRAM_ROW;
+	c = lcd_cursor % LCD_DDRAM_ROW;
+	if (r < LCD_ROWS && c < LCD_COLS)
+		lcd_shadow[r][c] = s;
+	if (++c < LCD_DDRAM_COLS)
+		lcd_cursor++;
+	else				// 0x27 -> 0x40, 0x67 -> 0x00
+		lcd_cursor = (r + 1) % 2 * LCD_DDRAM_ROW;
 }
  
 /*
@@ -64,7 +368,14 @@ void lcd_clear(void)
 {
 	LCD_RS_flag = 0;	// write characters
 	lcd_write(0x1);
+#if LCD_QUEUED
+	if (!lcd_q_on)				// else the ISR waits for the clear
+#endif
+#if LCD_BUSY_FLAG
+	if (!lcd_bf)
+#endif
 	DelayMs(2);
+	lcd_shadow_clear();
 }
  
 /* 
@@ -76,6 +387,7 @@ void lcd_clear(void)
 void lcd_putchar(char s){
 	LCD_RS_flag = 1;	// write characters
 	lcd_write(s);
+	lcd_shadow_put(s);
 }
  
 /* 
@@ -85,6 +397,7 @@ void lcd_puts(const char * s)
 {
 	LCD_RS_flag = 1;	// write characters
 	while(*s){
+		lcd_shadow_put(*s);
 		lcd_write(*s++);
  
         }
@@ -126,86 +439,180 @@ void lcd_puthex(unsigned char i)
 }
  
 /*
- * Go to the specified position
+ * Set the DDRAM address
  */
-void
-lcd_goto(unsigned char pos)
+static void lcd_ddram(unsigned char addr)
 {
 	LCD_RS_flag = 0;
-	lcd_write(0x80+pos);
+	lcd_write(0x80+addr);
+	lcd_cursor = addr;
 }
  
-/** 
- * initialise the LCD - put into 4 bit mode 
- *      4 bit mode, 2 lines
+/*
+ * Go to the specified position (second line starts at LCD_LINE2)
  */
-void lcd_init(void)
+void
+lcd_goto(unsigned char pos)
 {
-	LCD_RS(0);	// write control bytes
-    LCD_RS_flag = 0;
-	DelayMs(60);	// power on delay
- 
-	LATC = 0x03;	// FN set 1
-	LCD_STROBE();
-	DelayMs(10);     
+	lcd_ddram(pos / LCD_LINE2 * LCD_DDRAM_ROW + pos % LCD_LINE2);
+}
  
-	LCD_STROBE();     // fn set 2
-    DelayUs(50);
+/*
+ * Switch the display on (cursor as after lcd_init) or off,
+ * DDRAM contents are kept
+ */
+void lcd_display(unsigned char on)
+{
+	LCD_RS_flag = 0;
+	lcd_write(on ? LCD_DCTL : 0x08);
+}
  
-	LCD_STROBE();     // FN set 3
-	DelayUs(50);
+/*
+ * Frame buffer: blank the whole screen and go home
+ */
+void lcd_fb_clear(void)
+{
+	unsigned char r, c;
+
+	for (r = 0; r < LCD_ROWS; r++)
+		for (c = 0; c < LCD_COLS; c++)
+			lcd_fb[r][c] = ' ';
+	lcd_fb_pos = 0;
+}
  
-	LATC = 0x2;	// FN set #4 set 4 bit mode
-	LCD_STROBE();
-    DelayUs(50);
+/*
+ * Frame buffer: go to the specified position (same numbering as lcd_goto)
+ */
+void lcd_fb_goto(unsigned char pos)
+{
+	lcd_fb_pos = pos;
+}
  
-	lcd_write(0x29);	// 4 bit mode, 
+/*
+ * Frame buffer: print a character, characters off the screen are dropped
+ */
+void lcd_fb_putchar(char s)
+{
+	unsigned char r = lcd_fb_pos / LCD_LINE2;
+	unsigned char c = lcd_fb_pos % LCD_LINE2;
+
+	if (r < LCD_ROWS && c < LCD_COLS)
+		lcd_fb[r][c] = s;
+	lcd_fb_pos++;
+}
  
-	lcd_write(0x1D);	// int osc freq
-    lcd_write(0x79);	// contrast set
-    lcd_write(0x50);	// power / icon / contrast ctrl
-    lcd_write(0x6C);	// follower control
+/*
+ * Frame buffer: print a string
+ */
+void lcd_fb_puts(const char * s)
+{
+	while (*s)
+		lcd_fb_putchar(*s++);
+}
  
-	lcd_write(0x28);	// 4 bit mode, 1/16 duty, 5x8 font, radkovani
-	lcd_write(0x0E);	// display on, blink curson on
-	lcd_write(0x01);	// entry mode set
-	lcd_write(0x06);	// entry mode set
-    return;
+/*
+ * Frame buffer: send the cells which differ from the LCD. A run of changed
+ * cells needs a single lcd_goto, the LCD moves its cursor by itself.
+ */
+void lcd_fb_flush(void)
+{
+	unsigned char r, c, addr;
+
+	for (r = 0; r < LCD_ROWS; r++) {
+		for (c = 0; c < LCD_COLS; c++) {
+			if (lcd_fb[r][c] == lcd_shadow[r][c])
+				continue;
+			LCD_MARK(1);
+			addr = r * LCD_DDRAM_ROW + c;
+			if (addr != lcd_cursor)
+				lcd_ddram(addr);
+			lcd_putchar(lcd_fb[r][c]);
+		}
+	}
+#if LCD_QUEUED
+	if (!lcd_q_on)				// else the ISR ends the marker
+#endif
+	LCD_MARK(0);
 }
  
-void lcd_init33(void)
+/*
+ * Wait before a step of the init sequence; the busy flag covers the
+ * plain commands, LCD_W_CLEAR and LCD_W_SETTLE are waits it does not show
+ */
+#define LCD_W_CMD	0	// previous command done (busy flag / 50 us)
+#define LCD_W_CLEAR	1	// clear done (busy flag / 2 ms)
+#define LCD_W_SETTLE	2	// LCD_SETTLE_MS after follower on
+
+/*
+ * Init sequence once the LCD is in 4 bit mode: command, wait before it.
+ * Clear and entry mode are the same in both instruction tables, so they
+ * go before the follower and display on is the only step waiting for it.
+ */
+static const unsigned char lcd_init_tab[][2] = {
+	{ 0x29,		LCD_W_CMD },	// 4 bit mode, 2 lines, instruction table 1
+	{ 0x01,		LCD_W_CMD },	// clear
+	{ 0x06,		LCD_W_CLEAR },	// cursor autoincrement
+	{ LCD_OSC,	LCD_W_CMD },	// int osc freq
+	{ 0x79,		LCD_W_CMD },	// contrast set
+	{ LCD_POWER,	LCD_W_CMD },	// power / icon / contrast ctrl
+	{ LCD_FOLLOWER,	LCD_W_CMD },	// follower control
+	{ LCD_DCTL,	LCD_W_SETTLE },	// display on
+	{ 0x28,		LCD_W_CMD },	// 4 bit mode, 1/16 duty, 5x8 font, radkovani
+};
+
+/** 
+ * initialise the LCD - put into 4 bit mode 
+ *      4 bit mode, 2 lines
+ * With LCD_QUEUED it returns once the sequence is queued, the output
+ * written meanwhile follows it to the LCD.
+ */
+void lcd_init(void)
 {
+	unsigned char i, w;
+
+	LCD_RS(0);	// write control bytes
     LCD_RS_flag = 0;
- 	LCD_RS(0);	// write control bytes
- 
-	DelayMs(60);	// power on delay
+	DelayMs(41);	// power on delay, 40 ms + 2 % osc
  
-	LATC = 0x03;	// FN set 1
+	hal_lat_write(C, 0x03);	// FN set 1
 	LCD_STROBE();
-	DelayMs(10);
+	Delay100Us(42);	// 4.1 ms
  
 	LCD_STROBE();     // fn set 2
-    DelayUs(50);
+    DelayUs(110);
  
 	LCD_STROBE();     // FN set 3
 	DelayUs(50);
  
-	LATC = 0x2;	// FN set #4 set 4 bit mode
+	hal_lat_write(C, 0x2);	// FN set #4 set 4 bit mode
 	LCD_STROBE();
+#if LCD_BUSY_FLAG
+	lcd_bf = 1;	// busy flag can be read from now on
+#else
     DelayUs(50);
- 
-	lcd_write(0x29);	// 4 bit mode,
- 
-	//lcd_write(0x1D);	// int osc freq
-	lcd_write(0x1F);	// int osc freq
- 
-    lcd_write(0x79);	// contrast set
-	lcd_write(0x50 + 0x04);	// power / icon / contrast ctrl
-    lcd_write(0x6E);	// follower control
- 
-	lcd_write(0x28);	// 4 bit mode, 1/16 duty, 5x8 font, radkovani
-	lcd_write(0x0f);	// display on, blink curson on
-	lcd_write(0x01);	// clear
-	lcd_write(0x06);	// cursor autoincrement
-    return;
-}
\ No newline at end of file
+#endif
+#if LCD_QUEUED
+	lcd_q_start();	// rest of the sequence goes through the queue
+#endif
+ 
+	for (i = 0; i < sizeof(lcd_init_tab) / sizeof(lcd_init_tab[0]); i++) {
+		w = lcd_init_tab[i][1];
+#if LCD_QUEUED
+		if (lcd_q_on) {
+			lcd_q_put(lcd_init_tab[i][0], (w == LCD_W_SETTLE) ? LCD_Q_SETTLE :
+			    (lcd_init_tab[i][0] < 4) ? LCD_Q_SLOW : 0);
+			continue;
+		}
+#endif
+		if (w == LCD_W_SETTLE)
+			DelayMs(LCD_SETTLE_MS);
+#if LCD_BUSY_FLAG
+		else if (w == LCD_W_CLEAR && !lcd_bf)
+#else
+		else if (w == LCD_W_CLEAR)
+#endif
+			DelayMs(2);
+		lcd_write(lcd_init_tab[i][0]);
+	}
+	lcd_shadow_clear();
+}
\ No newline at end of file
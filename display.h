@@ -3,6 +3,21 @@
  *	See lcd.c for more info
  */
  
+#ifndef DISPLAY_H
+#define DISPLAY_H
+ 
+/* size of the frame buffer, rows start at multiples of LCD_LINE2 */
+ 
+#ifndef LCD_ROWS
+#define LCD_ROWS	2
+#endif
+#ifndef LCD_COLS
+#define LCD_COLS	16
+#endif
+#ifndef LCD_LINE2
+#define LCD_LINE2	40
+#endif
+ 
 /* write a byte to the LCD in 4 bit mode */
  
 extern void lcd_write(unsigned char);
@@ -18,22 +33,56 @@ extern void lcd_puts(const char * s);
 /* ... from static string */
 //extern void lcd_putsr(const rom char * s);
  
-/* Go to the specified position (second line starts at 40) */
+/* Go to the specified position (second line starts at LCD_LINE2) */
  
 extern void lcd_goto(unsigned char pos);
  
-/* intialize the LCD - call before anything else */
+/* intialize the LCD - call before anything else (LCD_3V3 selects the panel) */
  
 extern void lcd_init(void);
  
-/* intialize the LCD - 3.3V version */
- 
-extern void lcd_init33(void);
- 
 /* print a character  */
  
 extern void lcd_putchar(char s);
  
 /* print a byte in hexa */
  
-extern void lcd_puthex(unsigned char i);
\ No newline at end of file
+extern void lcd_puthex(unsigned char i);
+ 
+/* wait until everything written is in the LCD (queued output) */
+ 
+extern void lcd_sync(void);
+ 
+/* is output still on its way to the LCD ? */
+ 
+extern unsigned char lcd_busy(void);
+ 
+/* display on (1) or off (0), contents are kept */
+ 
+extern void lcd_display(unsigned char on);
+ 
+/* Timer2 interrupt handler of the queued output */
+ 
+extern void lcd_isr(void);
+ 
+/* frame buffer: blank the screen (nothing is sent until lcd_fb_flush) */
+ 
+extern void lcd_fb_clear(void);
+ 
+/* frame buffer: go to the specified position (second line starts at 40) */
+ 
+extern void lcd_fb_goto(unsigned char pos);
+ 
+/* frame buffer: print a character */
+ 
+extern void lcd_fb_putchar(char s);
+ 
+/* frame buffer: print a string */
+ 
+extern void lcd_fb_puts(const char * s);
+ 
+/* send only the changed characters of the frame buffer to the LCD */
+ 
+extern void lcd_fb_flush(void);
+ 
+#endif
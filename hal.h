@@ -0,0 +1,71 @@
+/*
+ * File:   hal.h
+ *
+ * Hardware abstraction of the port pins, the global interrupt enable,
+ * delays and SLEEP. On PIC18F46K22 every primitive is the register access
+ * or intrinsic it stands for, so the generated code is the same as with
+ * direct access. With HOST defined (make host) they are backed by the
+ * simulated registers and the virtual clock of host/host.c.
+ *
+ * P is the port letter (A .. E), n the bit number:
+ *
+ *	hal_lat(P)		output latch		LATx
+ *	hal_lat_write(P, v)	write latch		LATx = v
+ *	hal_lat_or/and(P, m)	modify latch		LATx |= m, LATx &= m
+ *	hal_port(P)		read pins		PORTx
+ *	hal_tris_write/or/and	pin directions		TRISx (1 = input)
+ *	hal_pin_write(P, n, v)	one output pin		LATxbits.LATxn = v
+ *	hal_pin_read(P, n)	one input pin		PORTxbits.Rxn
+ *	hal_pin_dir(P, n, in)	one pin direction	TRISxbits.TRISxn = in
+ *	hal_tx2(c)		send on EUSART2		TXREG2 = c
+ *	hal_delay_cy(n)		wait n Tcy (constant)	_delay(n)
+ *	hal_ee_read(a)		data EEPROM byte	EEADRH:EEADR = a, RD = 1, EEDATA
+ *	hal_ee_write(a, v)	start a byte write	EEDATA = v, WREN, 55h/AAh, WR = 1
+ *	hal_ee_busy()		write in progress	EECON1bits.WR
+ *
+ * hal_ee_write() runs the unlock sequence with GIEH cleared and restores it,
+ * the write then takes about 4 ms (hal_ee_busy()).
+ *
+ * hal_poll() is the body of loops which wait for an interrupt handler:
+ * nothing on the PIC, time for the handler to run on the host.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef HOST
+#include "host/host.h"
+#else
+#include <xc.h>
+
+#define hal_lat(P)		(LAT##P)
+#define hal_lat_write(P, v)	(LAT##P = (v))
+#define hal_lat_or(P, m)	(LAT##P |= (m))
+#define hal_lat_and(P, m)	(LAT##P &= (m))
+#define hal_port(P)		(PORT##P)
+#define hal_tris_write(P, v)	(TRIS##P = (v))
+#define hal_tris_or(P, m)	(TRIS##P |= (m))
+#define hal_tris_and(P, m)	(TRIS##P &= (m))
+#define hal_pin_write(P, n, v)	(LAT##P##bits.LAT##P##n = (v))
+#define hal_pin_read(P, n)	(PORT##P##bits.R##P##n)
+#define hal_pin_dir(P, n, in)	(TRIS##P##bits.TRIS##P##n = (in))
+
+#define hal_irq_off()		(INTCONbits.GIEH = 0)
+#define hal_irq_on()		(INTCONbits.GIEH = 1)
+#define hal_delay_us(x)		__delay_us(x)	/* x must be a constant */
+#define hal_delay_cy(n)		_delay(n)	/* n must be a constant */
+#define hal_spin(n)		{ uint8_t _cnt = (n); while (--_cnt); }	/* ~3 Tcy per n */
+#define hal_nop()		NOP()
+#define hal_poll()
+#define hal_sleep()		SLEEP()
+#define hal_tx2(c)		{ while (!TXSTA2bits.TRMT); TXREG2 = (c); }
+#define hal_ee_read(a)		(EEADRH = (uint8_t)((a) >> 8), EEADR = (uint8_t)(a), EECON1 = 0x01, EEDATA)
+#define hal_ee_write(a, v)	{ uint8_t _gie = INTCONbits.GIEH; \
+				  EEADRH = (uint8_t)((a) >> 8); EEADR = (uint8_t)(a); EEDATA = (v); \
+				  EECON1 = 0x04; INTCONbits.GIEH = 0; \
+				  EECON2 = 0x55; EECON2 = 0xaa; EECON1bits.WR = 1; \
+				  INTCONbits.GIEH = _gie; EECON1bits.WREN = 0; }
+#define hal_ee_busy()		(EECON1bits.WR)
+#endif
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * File:   at24c.c
+ *
+ * Model of a 24C32 EEPROM (4 KB, 32 byte pages, 2 byte word address) at
+ * I2C address 0xA4/0xA5 on SCL = RD0, SDA = RD1 (host build). It decodes
+ * the bus like host/pcf8583.c, timing is checked there. Written bytes
+ * go to the page buffer, the address wraps inside the page like on the
+ * chip; the STOP starts a write cycle of AT_WRITE_NS, meanwhile the
+ * address is not acknowledged (ACK polling). Reads continue over the
+ * whole array.
+ *
+ * Reported: write cycles, bytes written and read, address polls refused
+ * during a write cycle, and as violation a write which wrapped around its
+ * page (data overwritten).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define AT_ADDR		0xa4
+#define AT_SIZE		4096
+#define AT_PAGE		32
+#define AT_WRITE_NS	3000000ULL	/* typical, the datasheet allows 5 ms */
+#define SCL_BIT		0x01		/* RD0 */
+#define SDA_BIT		0x02		/* RD1 */
+
+#define P_IDLE		0		/* waiting for START */
+#define P_ADDR		1		/* receiving the address */
+#define P_WORDH		2		/* receiving the word address */
+#define P_WORDL		3
+#define P_WDATA		4		/* receiving data */
+#define P_RDATA		5		/* sending data */
+#define P_IGNORE	6		/* not for us / busy, waiting for START or STOP */
+
+extern uint8_t host_verbose;
+
+static uint8_t mem[AT_SIZE];
+static uint16_t ptr;
+static uint64_t busy_until;		/* ns, end of the write cycle */
+
+static uint8_t scl = 1, sda = 1;	/* line levels */
+static uint8_t pull;			/* chip pulls SDA low */
+static uint8_t phase = P_IDLE, nbit, shreg, rw, mack;
+static uint8_t nwr;			/* data bytes of the write */
+static uint16_t wstart;			/* their first address */
+
+static uint32_t n_cycles, n_wbytes, n_rbytes, n_polls, n_wrap;
+static uint64_t cycle_ns;		/* sum of the write cycles */
+
+/*
+ * Byte received, 8th clock finished: ACK it
+ */
+static void rx_byte(void)
+{
+	if (phase == P_ADDR) {
+		if ((shreg & 0xfe) != AT_ADDR) {
+			phase = P_IGNORE;
+			return;
+		}
+		if (host_ns() < busy_until) {
+			n_polls++;		/* write cycle, no ACK */
+			phase = P_IGNORE;
+			return;
+		}
+		rw = shreg & 1;
+	} else if (phase == P_WORDH) {
+		ptr = (uint16_t)(shreg << 8) % AT_SIZE;
+	} else if (phase == P_WORDL) {
+		ptr = (ptr & 0xff00) | shreg;
+		wstart = ptr;
+		nwr = 0;
+	} else {
+		if ((wstart & (AT_PAGE - 1)) + nwr++ == AT_PAGE)
+			n_wrap++;			/* once per write */
+		mem[ptr] = shreg;
+		ptr = (ptr & ~(AT_PAGE - 1)) | ((ptr + 1) & (AT_PAGE - 1));
+		n_wbytes++;
+	}
+	pull = 1;
+	nbit = 9;
+}
+
+/*
+ * Next byte to send, its MSB goes on SDA
+ */
+static void tx_next(void)
+{
+	shreg = mem[ptr];
+	ptr = (ptr + 1) % AT_SIZE;
+	n_rbytes++;
+	nbit = 0;
+	pull = !(shreg & 0x80);
+}
+
+static void scl_rise(void)
+{
+	if (phase == P_IDLE || phase == P_IGNORE)
+		return;
+	if (phase == P_RDATA) {
+		if (nbit == 8)
+			mack = !sda;		/* master ACK is low */
+	} else if (nbit < 8) {
+		shreg = (uint8_t)(shreg << 1) | sda;
+		nbit++;
+	}
+}
+
+static void scl_fall(void)
+{
+	switch (phase) {
+	case P_RDATA:
+		if (nbit < 8) {
+			nbit++;
+			pull = nbit < 8 && !(shreg & (0x80 >> nbit));
+		} else if (mack) {
+			tx_next();
+		} else {
+			phase = P_IGNORE;	/* NoACK after the last byte */
+		}
+		break;
+	case P_ADDR:
+	case P_WORDH:
+	case P_WORDL:
+	case P_WDATA:
+		if (nbit == 8) {
+			rx_byte();
+		} else if (nbit == 9) {		/* ACK clock done */
+			pull = 0;
+			nbit = 0;
+			shreg = 0;
+			if (phase == P_ADDR && rw) {
+				phase = P_RDATA;
+				tx_next();
+			} else if (phase != P_WDATA) {
+				phase++;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void start(void)
+{
+	nwr = 0;				/* only a STOP writes the page */
+	phase = P_ADDR;
+	nbit = 0;
+	shreg = 0;
+	pull = 0;
+}
+
+static void stop(void)
+{
+	if (phase == P_WDATA && nwr) {		/* write cycle of the page */
+		busy_until = host_ns() + AT_WRITE_NS;
+		cycle_ns += AT_WRITE_NS;
+		n_cycles++;
+		if (host_verbose)
+			printf("at24c %10.6f: page write %u bytes at %03x\n",
+			    host_ns() / 1e9, nwr, wstart);
+	}
+	nwr = 0;
+	phase = P_IDLE;
+	pull = 0;
+}
+
+static void at_out(uint8_t port)
+{
+	uint8_t lat = host_port[HOST_D].lat, tris = host_port[HOST_D].tris;
+	uint8_t c, d;
+
+	if (port != HOST_D)
+		return;
+	c = (tris & SCL_BIT) ? 1 : !!(lat & SCL_BIT);
+	d = ((tris & SDA_BIT) ? 1 : !!(lat & SDA_BIT)) && !pull;
+	if (c == scl && d != sda) {
+		sda = d;
+		if (c) {
+			if (d)
+				stop();
+			else
+				start();
+		}
+	} else if (c != scl) {
+		sda = d;
+		scl = c;
+		if (c)
+			scl_rise();
+		else
+			scl_fall();
+	}
+	sda = ((tris & SDA_BIT) ? 1 : !!(lat & SDA_BIT)) && !pull;
+}
+
+static uint8_t at_in(uint8_t port, uint8_t pins)
+{
+	if (port == HOST_D && pull)
+		return (pins & ~SDA_BIT);
+	return (pins);
+}
+
+static void at_report(void)
+{
+	if (!n_cycles && !n_rbytes && !n_polls)
+		return;
+	printf("at24c: %u write cycles (%.1f ms), %u bytes written, %u read, %u polls refused\n",
+	    n_cycles, cycle_ns / 1e6, n_wbytes, n_rbytes, n_polls);
+	if (n_wrap)
+		printf("at24c: violation: page write wrapped, %u times\n", n_wrap);
+}
+
+static host_model_t at_model = {
+	"at24c", at_out, at_in, NULL, at_report, NULL
+};
+
+__attribute__((constructor)) static void at_attach(void)
+{
+	memset(mem, 0xff, sizeof(mem));
+	host_i2c_claim(AT_ADDR);
+	host_attach(&at_model);
+}
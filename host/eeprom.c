@@ -0,0 +1,119 @@
+/*
+ * File:   eeprom.c
+ *
+ * Model of the 1 KB data EEPROM of PIC18F46K22 (host build) behind
+ * hal_ee_read(), hal_ee_write() and hal_ee_busy(). Erased bytes read
+ * 0xFF, a write keeps the memory busy for 4 ms (typical TDEW) and is
+ * counted per byte, so the report shows the wear of the busiest cell. A
+ * write while the previous one is still busy is a violation.
+ * With clock -e file the contents are kept in the file from one run to
+ * the next; without it every run starts erased.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define EE_SIZE		1024
+#define EE_WRITE_NS	4000000ULL	/* TDEW */
+
+extern uint8_t host_verbose;
+
+static uint8_t mem[EE_SIZE];
+static uint32_t wear[EE_SIZE];		/* writes per byte */
+static uint8_t loaded;
+static uint64_t busy_until;		/* ns */
+static uint32_t n_read, n_write, n_same, n_busy;
+
+/*
+ * Contents from the file (clock -e) or erased
+ */
+static void ee_load(void)
+{
+	FILE *fp;
+
+	if (loaded)
+		return;
+	loaded = 1;
+	memset(mem, 0xff, sizeof(mem));
+	if (!host_ee_file || !(fp = fopen(host_ee_file, "rb")))
+		return;
+	if (fread(mem, 1, sizeof(mem), fp) != sizeof(mem)) {
+		fprintf(stderr, "eeprom: %s: short file\n", host_ee_file);
+		exit(2);
+	}
+	fclose(fp);
+}
+
+uint8_t host_ee_read(uint16_t a)
+{
+	ee_load();
+	host_cycles(4);
+	n_read++;
+	return (mem[a % EE_SIZE]);
+}
+
+void host_ee_write(uint16_t a, uint8_t v)
+{
+	ee_load();
+	host_cycles(12);
+	a %= EE_SIZE;
+	if (host_ee_busy())
+		n_busy++;
+	if (mem[a] == v)
+		n_same++;
+	if (host_verbose)
+		printf("eeprom: %.6f s [%03x] = %02x\n", host_ns() / 1e9, a, v);
+	mem[a] = v;
+	wear[a]++;
+	n_write++;
+	busy_until = host_ns() + EE_WRITE_NS;
+}
+
+uint8_t host_ee_busy(void)
+{
+	host_cycles(1);
+	return (host_ns() < busy_until);
+}
+
+static void ee_report(void)
+{
+	FILE *fp;
+	uint32_t max = 0;
+	uint16_t i, at = 0, used = 0;
+
+	if (!loaded)
+		return;
+	for (i = 0; i < EE_SIZE; i++) {
+		if (wear[i])
+			used++;
+		if (wear[i] > max) {
+			max = wear[i];
+			at = i;
+		}
+	}
+	printf("eeprom: %u byte reads, %u byte writes (%u unchanged), %u bytes written, most %u at %03x\n",
+	    n_read, n_write, n_same, used, max, at);
+	if (n_busy)
+		printf("eeprom: violation: write while busy, %u times\n", n_busy);
+	if (!host_ee_file)
+		return;
+	if (!(fp = fopen(host_ee_file, "wb")) ||
+	    fwrite(mem, 1, sizeof(mem), fp) != sizeof(mem) || fclose(fp)) {
+		fprintf(stderr, "eeprom: %s: cannot write\n", host_ee_file);
+		return;
+	}
+	printf("eeprom: contents saved to %s\n", host_ee_file);
+}
+
+static host_model_t ee_model = {
+	"eeprom", NULL, NULL, NULL, ee_report, NULL
+};
+
+__attribute__((constructor)) static void ee_attach(void)
+{
+	host_attach(&ee_model);
+}
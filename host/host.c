@@ -0,0 +1,506 @@
+/*
+ * File:   host.c
+ *
+ * Host run time of the firmware: register file, virtual clock with the
+ * timers 0 to 4, interrupt dispatch, port pins and device models.
+ *
+ * Usage: clock [-t seconds] [-v] [-b] [-r ppm] [-s rtc-file] [-e eeprom-file]
+ *	-t	run the firmware for the virtual time (default 10 s)
+ *	-v	trace of the device models
+ *	-b	latency benchmark, key presses are injected (host/latency.c)
+ *	-r	error of the RTC crystal against the CPU clock in ppm
+ *	-s	registers of the RTC are loaded from the file at power on and
+ *		saved to it at the end (battery backup over a reset)
+ *	-e	contents of the data EEPROM are kept in the file, loaded at
+ *		start and saved at the end
+ * The statistics of the run and of the models are printed at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define FCY		(_XTAL_FREQ / 4)	/* instruction cycles per second */
+#define SOSC_HZ		32768UL
+#define NEVER		UINT64_MAX
+
+void isr(void);
+void firmware_main(void);
+
+volatile host_INTCON_t host_INTCON;
+volatile host_INTCON2_t host_INTCON2;
+volatile host_INTCON3_t host_INTCON3;
+volatile host_RCON_t host_RCON;
+volatile host_OSCCON_t host_OSCCON;
+volatile host_OSCTUNE_t host_OSCTUNE;
+volatile host_PIE1_t host_PIE1;
+volatile host_PIR1_t host_PIR1;
+volatile host_PIE3_t host_PIE3;
+volatile host_PIR3_t host_PIR3;
+volatile host_PIE5_t host_PIE5;
+volatile host_PIR5_t host_PIR5;
+volatile host_PMD0_t host_PMD0;
+volatile host_PMD1_t host_PMD1;
+volatile host_PMD2_t host_PMD2;
+volatile host_T0CON_t host_T0CON;
+volatile host_T1CON_t host_T1CON;
+volatile host_T3CON_t host_T3CON;
+volatile host_T2CON_t host_T2CON;
+volatile host_T4CON_t host_T4CON;
+volatile uint8_t TMR0L, TMR0H, TMR1L, TMR1H, T1GCON, TMR2, PR2 = 0xff, TMR3L, TMR3H, TMR4, PR4 = 0xff;
+volatile uint8_t SPBRG2, SPBRGH2, BAUDCON2, TXSTA2, RCSTA2;
+volatile uint8_t ANSELA, ANSELB, ANSELC, ANSELD, ANSELE, WPUB, IOCB;
+
+host_port_t host_port[HOST_PORTS] = {
+	{ 0, 0xff, 0 }, { 0, 0xff, 0 }, { 0, 0xff, 0 }, { 0, 0xff, 0 }, { 0, 0xff, 0 }
+};
+
+/* level of undriven input pins: button and I2C pull-ups */
+static const uint8_t host_pull[HOST_PORTS] = { 0x00, 0xff, 0x00, 0x03, 0x00 };
+
+static host_model_t *host_models = NULL;
+static uint64_t host_time = 0;			/* Tcy */
+static uint64_t host_end = 10ULL * FCY;
+static uint8_t host_in_isr = 0;
+uint8_t host_verbose = 0;
+int32_t host_rtc_ppm = 0;
+const char *host_rtc_file = NULL;
+const char *host_ee_file = NULL;
+
+/* prescaler remainders */
+static uint32_t t0_pre, t1_pre, t2_pre, t3_pre, t4_pre;
+static uint8_t t2_post, t4_post;
+static uint64_t sosc_acc;
+
+/* statistics */
+static uint32_t n_irq, n_sleep, n_idle, n_port;
+static uint64_t t_sleep;
+
+void host_attach(host_model_t *m)
+{
+	m->link = host_models;
+	host_models = m;
+}
+
+/*
+ * I2C addresses answered by the models, a model ignores the others
+ * silently
+ */
+static uint8_t host_i2c_addrs[16];
+
+void host_i2c_claim(uint8_t addr)
+{
+	host_i2c_addrs[(addr >> 4) & 0x0f] |= 1 << ((addr >> 1) & 7);
+}
+
+uint8_t host_i2c_claimed(uint8_t addr)
+{
+	return (!!(host_i2c_addrs[(addr >> 4) & 0x0f] & (1 << ((addr >> 1) & 7))));
+}
+
+uint64_t host_now(void)
+{
+	return (host_time);
+}
+
+uint64_t host_ns(void)
+{
+	return (host_time * 1000000000ULL / FCY);
+}
+
+uint64_t host_at_ns(uint64_t ns)
+{
+	return ((ns * FCY + 999999999ULL) / 1000000000ULL);
+}
+
+/*
+ * Timer0: 8 or 16 bit, Fosc/4 with prescaler
+ */
+static uint32_t t0_div(void)
+{
+	return (T0CONbits.PSA ? 1 : 2U << T0CONbits.T0PS);
+}
+
+static uint64_t t0_next(void)
+{
+	uint32_t v = T0CONbits.T08BIT ? TMR0L : (uint32_t)TMR0H << 8 | TMR0L;
+	uint32_t top = T0CONbits.T08BIT ? 0x100 : 0x10000;
+
+	if (!T0CONbits.TMR0ON)
+		return (NEVER);
+	return ((uint64_t)(top - v) * t0_div() - t0_pre);
+}
+
+static void t0_step(uint32_t n)
+{
+	uint32_t d = t0_div(), t, v;
+
+	if (!T0CONbits.TMR0ON)
+		return;
+	t = t0_pre + n;
+	t0_pre = t % d;
+	t /= d;
+	if (T0CONbits.T08BIT) {
+		v = TMR0L + t;
+		if (v > 0xff)
+			INTCONbits.TMR0IF = 1;
+		TMR0L = (uint8_t)v;
+	} else {
+		v = ((uint32_t)TMR0H << 8 | TMR0L) + t;
+		if (v > 0xffff)
+			INTCONbits.TMR0IF = 1;
+		TMR0H = (uint8_t)(v >> 8);
+		TMR0L = (uint8_t)v;
+	}
+}
+
+/*
+ * Timer1: 16 bit, Fosc/4, Fosc or SOSC with prescaler
+ */
+static uint64_t t1_next(void)
+{
+	uint64_t ticks;
+
+	if (!T1CONbits.TMR1ON)
+		return (NEVER);
+	ticks = (uint64_t)(0x10000 - ((uint32_t)TMR1H << 8 | TMR1L))
+	    * (1U << T1CONbits.T1CKPS) - t1_pre;
+	if (T1CONbits.TMR1CS == 2)		/* SOSC */
+		return ((ticks * FCY - sosc_acc + SOSC_HZ - 1) / SOSC_HZ);
+	if (T1CONbits.TMR1CS == 1)		/* Fosc */
+		return ((ticks + 3) / 4);
+	return (ticks);
+}
+
+static void t1_step(uint32_t n)
+{
+	uint64_t t;
+	uint32_t v, d = 1U << T1CONbits.T1CKPS;
+
+	if (!T1CONbits.TMR1ON)
+		return;
+	if (T1CONbits.TMR1CS == 2) {
+		sosc_acc += (uint64_t)n * SOSC_HZ;
+		t = sosc_acc / FCY;
+		sosc_acc %= FCY;
+	} else {
+		t = T1CONbits.TMR1CS == 1 ? 4ULL * n : n;
+	}
+	t += t1_pre;
+	t1_pre = t % d;
+	t /= d;
+	v = ((uint32_t)TMR1H << 8 | TMR1L) + (uint32_t)t;
+	if (v > 0xffff)
+		PIR1bits.TMR1IF = 1;
+	TMR1H = (uint8_t)(v >> 8);
+	TMR1L = (uint8_t)v;
+}
+
+/*
+ * Timer3: 16 bit, Fosc/4 or Fosc with prescaler, free running (profiler)
+ */
+static void t3_step(uint32_t n)
+{
+	uint64_t t;
+	uint32_t d = 1U << T3CONbits.T3CKPS;
+
+	if (!T3CONbits.TMR3ON)
+		return;
+	t = (T3CONbits.TMR3CS == 1 ? 4ULL * n : n) + t3_pre;
+	t3_pre = t % d;
+	t = ((uint32_t)TMR3H << 8 | TMR3L) + t / d;
+	TMR3H = (uint8_t)(t >> 8);
+	TMR3L = (uint8_t)t;
+}
+
+/*
+ * Timer2/4: 8 bit with period register, prescaler and postscaler
+ */
+static const uint8_t t2_ps[4] = { 1, 4, 16, 16 };
+
+static uint64_t t24_next(uint8_t con, uint8_t tmr, uint8_t pr, uint32_t pre, uint8_t post)
+{
+	uint32_t period = pr + 1;
+
+	if (!(con & 0x04))
+		return (NEVER);
+	return (((uint64_t)(((con >> 3) & 0x0f) - post) * period + period - tmr)
+	    * t2_ps[con & 3] - pre);
+}
+
+static uint8_t t24_step(uint8_t con, volatile uint8_t *tmr, uint8_t pr,
+    uint32_t *pre, uint8_t *post, uint32_t n)
+{
+	uint32_t t, period = pr + 1, ps = t2_ps[con & 3];
+	uint32_t outps = ((con >> 3) & 0x0f) + 1, matches;
+
+	if (!(con & 0x04))
+		return (0);
+	t = *pre + n;
+	*pre = t % ps;
+	t = t / ps + *tmr;
+	matches = t / period;
+	*tmr = (uint8_t)(t % period);
+	matches += *post;
+	*post = (uint8_t)(matches % outps);
+	return (matches >= outps);
+}
+
+/*
+ * Cycles until the next timer flag or model input change
+ */
+static uint64_t host_next(void)
+{
+	uint64_t n = t0_next(), m;
+	host_model_t *p;
+
+	if ((m = t1_next()) < n)
+		n = m;
+	if ((m = t24_next(T2CON, TMR2, PR2, t2_pre, t2_post)) < n)
+		n = m;
+	if ((m = t24_next(T4CON, TMR4, PR4, t4_pre, t4_post)) < n)
+		n = m;
+	for (p = host_models; p; p = p->link) {
+		if (p->next && (m = p->next()) != NEVER)
+			if ((m = m > host_time ? m - host_time : 1) < n)
+				n = m;
+	}
+	return (n ? n : 1);
+}
+
+/*
+ * Let n cycles pass on all timers
+ */
+static void host_step(uint32_t n)
+{
+	host_time += n;
+	t0_step(n);
+	t1_step(n);
+	t3_step(n);
+	if (t24_step(T2CON, &TMR2, PR2, &t2_pre, &t2_post, n))
+		PIR1bits.TMR2IF = 1;
+	if (t24_step(T4CON, &TMR4, PR4, &t4_pre, &t4_post, n))
+		PIR5bits.TMR4IF = 1;
+	host_inputs();
+	if (host_time >= host_end)
+		host_finish(NULL);
+}
+
+/*
+ * Pending enabled interrupt
+ */
+static uint8_t host_pending(void)
+{
+	return ((INTCONbits.TMR0IE && INTCONbits.TMR0IF)
+	    || (INTCONbits.INT0IE && INTCONbits.INT0IF)
+	    || (INTCONbits.RBIE && INTCONbits.RBIF)
+	    || (INTCON3bits.INT1IE && INTCON3bits.INT1IF)
+	    || (INTCON3bits.INT2IE && INTCON3bits.INT2IF)
+	    || (PIE1bits.TMR1IE && PIR1bits.TMR1IF)
+	    || (PIE1bits.TMR2IE && PIR1bits.TMR2IF)
+	    || (PIE3bits.SSP2IE && PIR3bits.SSP2IF)
+	    || (PIE5bits.TMR4IE && PIR5bits.TMR4IF));
+}
+
+/*
+ * Vector to the interrupt handler like the CPU: GIEH is cleared meanwhile
+ */
+static void host_irq(void)
+{
+	if (!INTCONbits.GIEH || host_in_isr || !host_pending())
+		return;
+	host_in_isr = 1;
+	INTCONbits.GIEH = 0;
+	isr();
+	n_irq++;
+	INTCONbits.GIEH = 1;
+	host_in_isr = 0;
+}
+
+void host_cycles(uint32_t n)
+{
+	uint64_t s;
+
+	while (n) {
+		s = host_next();
+		if (s > n)
+			s = n;
+		host_step((uint32_t)s);
+		n -= (uint32_t)s;
+		host_irq();
+	}
+}
+
+void host_delay_us(uint32_t us)
+{
+	host_cycles((uint32_t)((uint64_t)us * FCY / 1000000UL));
+}
+
+/*
+ * SLEEP: IDLE (IDLEN = 1) keeps the timers running, SLEEP stops all of
+ * them but the SOSC Timer1. Wakes on any enabled interrupt flag, with or
+ * without GIEH.
+ */
+void host_sleep(void)
+{
+	uint64_t s, t0 = host_time;
+	uint8_t deep = !OSCCONbits.IDLEN;
+
+	if (host_in_isr)
+		return;
+	if (deep)
+		n_sleep++;
+	else
+		n_idle++;
+	while (!host_pending()) {
+		uint8_t t0con = T0CON, t1con = T1CON, t2con = T2CON, t3con = T3CON, t4con = T4CON;
+
+		if (deep) {		/* only SOSC and the pins go on */
+			T0CON &= ~0x80;
+			T2CON &= ~0x04;
+			T3CON &= ~0x01;
+			T4CON &= ~0x04;
+			if (T1CONbits.TMR1CS != 2)
+				T1CON &= ~0x01;
+		}
+		s = host_next();
+		if (s != NEVER)
+			host_step(s > 0x7fffffff ? 0x7fffffff : (uint32_t)s);
+		T0CON = t0con;
+		T1CON = t1con;
+		T2CON = t2con;
+		T3CON = t3con;
+		T4CON = t4con;
+		if (s == NEVER)
+			host_finish("SLEEP without a wake-up source");
+	}
+	t_sleep += host_time - t0;
+	host_irq();
+}
+
+void host_irq_on(void)
+{
+	INTCONbits.GIEH = 1;
+	host_irq();
+}
+
+/*
+ * EUSART2 sends a character in 10 bit times
+ */
+void host_tx(uint8_t c)
+{
+	uint32_t brg = ((uint32_t)SPBRGH2 << 8 | SPBRG2) + 1;
+
+	host_cycles(10 * brg);
+	if (c != '\r')
+		putchar(c);
+}
+
+/*
+ * Pin levels: outputs follow the latch, inputs the pull-ups and models.
+ * Edges on RB0..RB2 set INTxIF, a change on the enabled IOCB pins RBIF.
+ */
+void host_inputs(void)
+{
+	static uint8_t rb_last = 0xff;
+	host_model_t *m;
+	uint8_t i, in, fall;
+
+	for (i = 0; i < HOST_PORTS; i++) {
+		in = host_pull[i];
+		for (m = host_models; m; m = m->link)
+			if (m->in)
+				in = m->in(i, in);
+		host_port[i].pins = (host_port[i].lat & ~host_port[i].tris)
+		    | (in & host_port[i].tris);
+	}
+	in = host_port[HOST_B].pins;
+	fall = rb_last & ~in;
+	if ((fall & 0x01) && !INTCON2bits.INTEDG0)
+		INTCONbits.INT0IF = 1;
+	if ((fall & 0x02) && !INTCON2bits.INTEDG1)
+		INTCON3bits.INT1IF = 1;
+	if ((fall & 0x04) && !INTCON2bits.INTEDG2)
+		INTCON3bits.INT2IF = 1;
+	if ((rb_last ^ in) & IOCB)
+		INTCONbits.RBIF = 1;
+	rb_last = in;
+}
+
+static void host_out(uint8_t p)
+{
+	host_model_t *m;
+
+	n_port++;
+	host_inputs();
+	for (m = host_models; m; m = m->link)
+		if (m->out)
+			m->out(p);
+	host_inputs();
+	host_cycles(1);
+}
+
+void host_lat_write(uint8_t p, uint8_t v)
+{
+	host_port[p].lat = v;
+	host_out(p);
+}
+
+void host_tris_write(uint8_t p, uint8_t v)
+{
+	host_port[p].tris = v;
+	host_out(p);
+}
+
+uint8_t host_port_read(uint8_t p)
+{
+	host_cycles(1);
+	return (host_port[p].pins);
+}
+
+void host_finish(const char *why)
+{
+	host_model_t *m;
+
+	printf("host: %.3f s virtual time%s%s\n", (double)host_time / FCY,
+	    why ? ", stopped: " : "", why ? why : "");
+	printf("host: %u interrupts, %u IDLE + %u SLEEP waits (%.1f %% of the time)\n",
+	    n_irq, n_idle, n_sleep, host_time ? 100.0 * t_sleep / host_time : 0.0);
+	printf("host: %u port writes\n", n_port);
+	for (m = host_models; m; m = m->link)
+		if (m->report)
+			m->report();
+	exit(why ? 1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			host_end = (uint64_t)(atof(argv[++i]) * FCY);
+		} else if (!strcmp(argv[i], "-v")) {
+			host_verbose = 1;
+		} else if (!strcmp(argv[i], "-b")) {
+			host_bench = 1;
+		} else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			host_rtc_ppm = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			host_rtc_file = argv[++i];
+		} else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+			host_ee_file = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [-t seconds] [-v] [-b] [-r ppm] [-s rtc-file] [-e eeprom-file]\n",
+			    argv[0]);
+			return (2);
+		}
+	}
+	host_inputs();
+	firmware_main();
+	host_finish("main() returned");
+	return (0);
+}
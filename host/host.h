@@ -0,0 +1,179 @@
+/*
+ * File:   host.h
+ *
+ * Host (Linux, gcc) side of hal.h. The special function registers used by
+ * the firmware are plain variables with the XC8 names and bit fields, the
+ * timers 0 to 4 are simulated on a virtual clock which advances on
+ * every HAL port access (one Tcy), delay and SLEEP. Firmware code between
+ * HAL calls takes no virtual time.
+ *
+ * Port pins go through host_port[] so that device models (host_model_t)
+ * see every output change and drive the input pins.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+/* ports */
+#define HOST_A		0
+#define HOST_B		1
+#define HOST_C		2
+#define HOST_D		3
+#define HOST_E		4
+#define HOST_PORTS	5
+
+typedef struct {
+	uint8_t lat;			/* output latch */
+	uint8_t tris;			/* 1 = input */
+	uint8_t pins;			/* level of the pins */
+} host_port_t;
+
+extern host_port_t host_port[HOST_PORTS];
+
+/* device model attached to the pins */
+typedef struct host_model {
+	const char *name;
+	void (*out)(uint8_t port);		/* output latch or direction changed */
+	uint8_t (*in)(uint8_t port, uint8_t pins);	/* drive the input pins */
+	uint64_t (*next)(void);			/* cycle of the next input change */
+	void (*report)(void);			/* statistics at the end of the run */
+	struct host_model *link;
+} host_model_t;
+
+void host_attach(host_model_t *);
+void host_i2c_claim(uint8_t);			/* model answers this 8 bit I2C address */
+uint8_t host_i2c_claimed(uint8_t);		/* is there a model for it ? */
+uint64_t host_now(void);			/* virtual time in Tcy */
+uint64_t host_ns(void);				/* virtual time in ns */
+uint64_t host_at_ns(uint64_t);			/* cycle of the time in ns */
+void host_cycles(uint32_t);			/* let n Tcy pass */
+void host_delay_us(uint32_t);
+void host_sleep(void);				/* SLEEP instruction */
+void host_irq_on(void);				/* GIEH = 1 */
+void host_tx(uint8_t);				/* EUSART2 output to stdout */
+void host_inputs(void);				/* re-read the model inputs */
+void host_lat_write(uint8_t, uint8_t);
+void host_tris_write(uint8_t, uint8_t);
+uint8_t host_port_read(uint8_t);
+void host_finish(const char *);			/* end of the run, reports */
+uint8_t host_ee_read(uint16_t);			/* data EEPROM (host/eeprom.c) */
+void host_ee_write(uint16_t, uint8_t);
+uint8_t host_ee_busy(void);
+
+/* end-to-end latency benchmark (host/latency.c, clock -b) */
+extern uint8_t host_bench;
+extern int32_t host_rtc_ppm;			/* RTC crystal error, clock -r */
+extern const char *host_rtc_file;		/* RTC backup battery, clock -s */
+extern const char *host_ee_file;		/* data EEPROM contents, clock -e */
+void host_lat_second(uint64_t);			/* RTC started a second at ns */
+void host_lat_ddram(uint8_t);			/* LCD content changed at address */
+
+/* XC8 keywords */
+#define __interrupt(...)
+
+/*
+ * Special function registers. Bit fields list the bits the firmware uses,
+ * at their datasheet positions.
+ */
+#define HOST_SFR(n, ...) \
+	typedef union { uint8_t r; struct { __VA_ARGS__ }; } host_##n##_t; \
+	extern volatile host_##n##_t host_##n
+
+HOST_SFR(INTCON, unsigned RBIF:1, INT0IF:1, TMR0IF:1, RBIE:1, INT0IE:1, TMR0IE:1, GIEL:1, GIEH:1;);
+HOST_SFR(INTCON2, unsigned RBIP:1, :1, TMR0IP:1, :1, INTEDG2:1, INTEDG1:1, INTEDG0:1, RBPU:1;);
+HOST_SFR(INTCON3, unsigned INT1IF:1, INT2IF:1, :1, INT1IE:1, INT2IE:1, :1, INT1IP:1, INT2IP:1;);
+HOST_SFR(RCON, unsigned :7, IPEN:1;);
+HOST_SFR(OSCCON, unsigned SCS:2, HFIOFS:1, OSTS:1, IRCF:3, IDLEN:1;);
+HOST_SFR(OSCTUNE, unsigned TUN:6, PLLEN:1, INTSRC:1;);
+HOST_SFR(PIE1, unsigned TMR1IE:1, TMR2IE:1, :6;);
+HOST_SFR(PIR1, unsigned TMR1IF:1, TMR2IF:1, :6;);
+HOST_SFR(PIE3, unsigned :7, SSP2IE:1;);
+HOST_SFR(PIR3, unsigned :7, SSP2IF:1;);
+HOST_SFR(PIE5, unsigned TMR4IE:1, TMR5IE:1, TMR6IE:1, :5;);
+HOST_SFR(PIR5, unsigned TMR4IF:1, TMR5IF:1, TMR6IF:1, :5;);
+HOST_SFR(PMD0, unsigned TMR1MD:1, TMR2MD:1, TMR3MD:1, TMR4MD:1, TMR5MD:1, TMR6MD:1, UART1MD:1, UART2MD:1;);
+HOST_SFR(PMD1, unsigned CCP1MD:1, CCP2MD:1, CCP3MD:1, CCP4MD:1, CCP5MD:1, :1, MSSP1MD:1, MSSP2MD:1;);
+HOST_SFR(PMD2, unsigned ADCMD:1, CMP1MD:1, CMP2MD:1, CTMUMD:1, :4;);
+HOST_SFR(T0CON, unsigned T0PS:3, PSA:1, T0SE:1, T0CS:1, T08BIT:1, TMR0ON:1;);
+HOST_SFR(T1CON, unsigned TMR1ON:1, T1RD16:1, T1SYNC:1, T1SOSCEN:1, T1CKPS:2, TMR1CS:2;);
+HOST_SFR(T3CON, unsigned TMR3ON:1, T3RD16:1, T3SYNC:1, T3SOSCEN:1, T3CKPS:2, TMR3CS:2;);
+HOST_SFR(T2CON, unsigned T2CKPS:2, TMR2ON:1, T2OUTPS:4, :1;);
+HOST_SFR(T4CON, unsigned T4CKPS:2, TMR4ON:1, T4OUTPS:4, :1;);
+
+#define INTCON		host_INTCON.r
+#define INTCONbits	host_INTCON
+#define INTCON2		host_INTCON2.r
+#define INTCON2bits	host_INTCON2
+#define INTCON3		host_INTCON3.r
+#define INTCON3bits	host_INTCON3
+#define RCON		host_RCON.r
+#define RCONbits	host_RCON
+#define OSCCON		host_OSCCON.r
+#define OSCCONbits	host_OSCCON
+#define OSCTUNE		host_OSCTUNE.r
+#define OSCTUNEbits	host_OSCTUNE
+#define PIE1		host_PIE1.r
+#define PIE1bits	host_PIE1
+#define PIR1		host_PIR1.r
+#define PIR1bits	host_PIR1
+#define PIE3		host_PIE3.r
+#define PIE3bits	host_PIE3
+#define PIR3		host_PIR3.r
+#define PIR3bits	host_PIR3
+#define PIE5		host_PIE5.r
+#define PIE5bits	host_PIE5
+#define PIR5		host_PIR5.r
+#define PIR5bits	host_PIR5
+#define PMD0		host_PMD0.r
+#define PMD0bits	host_PMD0
+#define PMD1		host_PMD1.r
+#define PMD1bits	host_PMD1
+#define PMD2		host_PMD2.r
+#define PMD2bits	host_PMD2
+#define T0CON		host_T0CON.r
+#define T0CONbits	host_T0CON
+#define T1CON		host_T1CON.r
+#define T1CONbits	host_T1CON
+#define T3CON		host_T3CON.r
+#define T3CONbits	host_T3CON
+#define T2CON		host_T2CON.r
+#define T2CONbits	host_T2CON
+#define T4CON		host_T4CON.r
+#define T4CONbits	host_T4CON
+
+extern volatile uint8_t TMR0L, TMR0H, TMR1L, TMR1H, T1GCON, TMR2, PR2, TMR3L, TMR3H, TMR4, PR4;
+extern volatile uint8_t SPBRG2, SPBRGH2, BAUDCON2, TXSTA2, RCSTA2;
+extern volatile uint8_t ANSELA, ANSELB, ANSELC, ANSELD, ANSELE, WPUB, IOCB;
+
+/* HAL primitives */
+#define hal_lat(P)		(host_port[HOST_##P].lat)
+#define hal_lat_write(P, v)	host_lat_write(HOST_##P, (uint8_t)(v))
+#define hal_lat_or(P, m)	host_lat_write(HOST_##P, host_port[HOST_##P].lat | (m))
+#define hal_lat_and(P, m)	host_lat_write(HOST_##P, host_port[HOST_##P].lat & (m))
+#define hal_port(P)		host_port_read(HOST_##P)
+#define hal_tris_write(P, v)	host_tris_write(HOST_##P, (uint8_t)(v))
+#define hal_tris_or(P, m)	host_tris_write(HOST_##P, host_port[HOST_##P].tris | (m))
+#define hal_tris_and(P, m)	host_tris_write(HOST_##P, host_port[HOST_##P].tris & (m))
+#define hal_pin_write(P, n, v)	host_lat_write(HOST_##P, (v) ? \
+				    host_port[HOST_##P].lat | (1 << (n)) : \
+				    host_port[HOST_##P].lat & ~(1 << (n)))
+#define hal_pin_read(P, n)	((host_port_read(HOST_##P) >> (n)) & 1)
+#define hal_pin_dir(P, n, in)	host_tris_write(HOST_##P, (in) ? \
+				    host_port[HOST_##P].tris | (1 << (n)) : \
+				    host_port[HOST_##P].tris & ~(1 << (n)))
+#define hal_irq_off()		(INTCONbits.GIEH = 0)
+#define hal_irq_on()		host_irq_on()
+#define hal_delay_us(x)		host_delay_us(x)
+#define hal_delay_cy(n)		host_cycles(n)
+#define hal_spin(n)		host_cycles(3 * (n))
+#define hal_nop()		host_cycles(1)
+#define hal_poll()		host_cycles(3)
+#define hal_sleep()		host_sleep()
+#define hal_tx2(c)		host_tx(c)
+#define hal_ee_read(a)		host_ee_read(a)
+#define hal_ee_write(a, v)	host_ee_write(a, v)
+#define hal_ee_busy()		host_ee_busy()
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ * File:   latency.c
+ *
+ * End-to-end latency benchmark of the host build (clock -b). Two kinds
+ * of stimulus are timed until the LCD shows their effect:
+ *
+ *	key	BTN3 (RB2) is pressed with contact bounce and released again;
+ *		the mode switch acts on the release, so the last release edge
+ *		is the stimulus and the first DDRAM change of address 2 (':'
+ *		in clock mode, a minutes bit in binary mode) the response
+ *	second	the PCF8583 model rolls over to a new second; the first
+ *		DDRAM change of any other address is the response
+ *
+ * Keys are pressed 100 .. 300 ms after a second rollover and released
+ * HOLD later, so the two kinds do not overlap; a random fraction of a
+ * millisecond spreads the stimulus over the phases of the 1 ms scheduler
+ * tick. The random phases come from a fixed seed, every run of the same
+ * firmware gives the same numbers. With BENCH_MARK the falling edge of
+ * the RA0 marker is timed as a response to both kinds, which is what an
+ * oscilloscope sees on the target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define KEY_BIT		0x04		/* RB2 = BTN3 */
+#define MARK_BIT	0x01		/* RA0 */
+
+#define MS		1000000ULL	/* ns */
+#define BOUNCE		5		/* edges of contact bounce, odd */
+#define BOUNCE_NS	300000ULL	/* between them */
+#define HOLD		(100 * MS)
+#define SAMPLES		4096
+
+#define R_KEY		0		/* key to DDRAM */
+#define R_KEY_MARK	1		/* key to marker */
+#define R_SEC		2		/* second to DDRAM */
+#define R_SEC_MARK	3		/* second to marker */
+#define RESULTS		4
+
+static const char *const r_name[RESULTS] = {
+	"key -> DDRAM", "key -> marker", "second -> DDRAM", "second -> marker"
+};
+
+typedef struct {
+	uint32_t n, missed;
+	uint32_t us[SAMPLES];
+} result_t;
+
+uint8_t host_bench = 0;
+
+static result_t res[RESULTS];
+static uint64_t pending[RESULTS];	/* stimulus time + 1, 0 = none */
+static uint64_t t_second;		/* last second rollover */
+static uint64_t edges[2 * BOUNCE];	/* press and release with bounce */
+static uint8_t n_edges, edge, key_down;
+static uint8_t mark = 0, mark_seen = 0;
+static uint32_t seed = 12345;
+
+static uint32_t rnd(uint32_t n)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return (seed % n);
+}
+
+static void sample(uint8_t r, uint64_t now)
+{
+	if (!pending[r])
+		return;
+	if (res[r].n < SAMPLES)
+		res[r].us[res[r].n++] = (uint32_t)((now - (pending[r] - 1)) / 1000);
+	pending[r] = 0;
+}
+
+static void stimulus(uint8_t r, uint64_t ns)
+{
+	if (pending[r])			/* previous one never showed */
+		res[r].missed++;
+	pending[r] = ns + 1;
+}
+
+/*
+ * Next key press: 100 .. 300 ms after the 2nd to 3rd rollover from now,
+ * at any phase of the tick
+ */
+static void key_plan(void)
+{
+	uint64_t t = t_second + (2 + rnd(2)) * 1000 * MS + (100 + rnd(200)) * MS + rnd(MS);
+	uint8_t i;
+
+	n_edges = 0;
+	for (i = 0; i < BOUNCE; i++)
+		edges[n_edges++] = t + i * BOUNCE_NS;
+	t += HOLD;
+	for (i = 0; i < BOUNCE; i++)
+		edges[n_edges++] = t + i * BOUNCE_NS;
+	edge = 0;
+}
+
+/*
+ * The PCF8583 model started a new second at time ns
+ */
+void host_lat_second(uint64_t ns)
+{
+	if (!host_bench || ns < 500 * MS)	/* clock set up at start */
+		return;
+	t_second = ns;
+	stimulus(R_SEC, ns);
+	stimulus(R_SEC_MARK, ns);
+	if (!n_edges)
+		key_plan();
+}
+
+/*
+ * The LCD model changed DDRAM address a
+ */
+void host_lat_ddram(uint8_t a)
+{
+	uint64_t now;
+
+	if (!host_bench)
+		return;
+	now = host_ns();
+	if (a == 2)
+		sample(R_KEY, now);
+	else
+		sample(R_SEC, now);
+}
+
+/*
+ * Contact bounce: the key level toggles on every edge
+ */
+static uint8_t lat_in(uint8_t port, uint8_t pins)
+{
+	uint64_t now;
+
+	if (port != HOST_B || !n_edges)
+		return (pins);
+	now = host_ns();
+	while (edge < n_edges && now >= edges[edge])
+		edge++;
+	key_down = edge & 1;
+	if (edge == n_edges) {		/* last release edge */
+		stimulus(R_KEY, edges[n_edges - 1]);
+		stimulus(R_KEY_MARK, edges[n_edges - 1]);
+		n_edges = 0;
+		key_down = 0;
+	}
+	return (key_down ? pins & ~KEY_BIT : pins);
+}
+
+static uint64_t lat_next(void)
+{
+	if (!n_edges || edge >= n_edges)
+		return (UINT64_MAX);
+	return (host_at_ns(edges[edge]));
+}
+
+/*
+ * RA0 marker: falling edge = frame is in the LCD
+ */
+static void lat_out(uint8_t port)
+{
+	uint8_t m;
+	uint64_t now;
+
+	if (port != HOST_A || !host_bench)
+		return;
+	m = host_port[HOST_A].lat & ~host_port[HOST_A].tris & MARK_BIT;
+	if (mark && !m) {
+		mark_seen = 1;
+		now = host_ns();
+		sample(R_KEY_MARK, now);
+		sample(R_SEC_MARK, now);
+	}
+	mark = m;
+}
+
+static int cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x < y ? -1 : x > y);
+}
+
+static void lat_report(void)
+{
+	result_t *r;
+	uint8_t i;
+
+	if (!host_bench)
+		return;
+	for (i = 0; i < RESULTS; i++) {
+		r = &res[i];
+		if ((i == R_KEY_MARK || i == R_SEC_MARK) && !mark_seen)
+			continue;		/* no BENCH_MARK */
+		if (!r->n) {
+			if (r->missed)
+				printf("latency: %-17s no response, %u missed\n", r_name[i], r->missed);
+			continue;
+		}
+		qsort(r->us, r->n, sizeof(r->us[0]), cmp);
+		printf("latency: %-17s n %4u  p50 %8.3f  p99 %8.3f  max %8.3f ms",
+		    r_name[i], r->n, r->us[r->n / 2] / 1e3,
+		    r->us[(r->n * 99 - 1) / 100] / 1e3, r->us[r->n - 1] / 1e3);
+		if (r->missed)
+			printf("  (%u missed)", r->missed);
+		printf("\n");
+	}
+}
+
+static host_model_t lat_model = {
+	"latency", lat_out, lat_in, lat_next, lat_report, NULL
+};
+
+__attribute__((constructor)) static void lat_attach(void)
+{
+	host_attach(&lat_model);
+}
@@ -0,0 +1,508 @@
+/*
+ * File:   pcf8583.c
+ *
+ * Bit-level model of the PCF8583 clock/RAM at I2C address 0xA0/0xA1 on
+ * SCL = RD0, SDA = RD1 (host build). The bus is decoded from the pin
+ * transitions the firmware makes: START, STOP, address, data and ACK, the
+ * chip answers like a slave would, so the bit-banged driver runs unchanged.
+ *
+ * Registers (256 bytes, the word address increments after every byte):
+ *	0x00 control (bit 7 stops counting), 0x01 hundredths, 0x02 seconds,
+ *	0x03 minutes, 0x04 hours, 0x05 year/date, 0x06 weekday/month,
+ *	0x07 timer, 0x08..0x0F alarm, 0x10..0xFF RAM
+ * The time counts from the virtual clock, off by clock -r ppm against the
+ * CPU oscillator. INT (RB5, open drain) gives the 1 Hz output: low for
+ * the first half of every second. With clock -s file the registers and
+ * the RAM are kept in the file from one run to the next like the backup
+ * battery would (the time stands still in between); without it every
+ * run starts from the power-on reset: 00:00:00, counting, RAM cleared.
+ *
+ * Protocol violations (timing of the standard mode, SDA changing while
+ * SCL is high inside a byte, bus contention at sampling) are counted, and
+ * every transaction START .. STOP is measured in SCL clocks and bus time.
+ * Transactions to an address another model claimed (host_i2c_claim())
+ * are left to that model, with their violations.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define PCF_ADDR	0xa0
+#define SCL_BIT		0x01		/* RD0 */
+#define SDA_BIT		0x02		/* RD1 */
+#define INT_BIT		0x20		/* RB5 */
+
+/* one hundredth in ns, + ppm = RTC runs fast */
+#define HS_NS		(10000000000000ULL / (uint64_t)(1000000 + host_rtc_ppm))
+
+/* standard mode (100 kHz) minimum times in ns */
+#define T_LOW		4700
+#define T_HIGH		4000
+#define T_SU_STA	4700
+#define T_HD_STA	4000
+#define T_SU_STO	4000
+#define T_BUF		4700
+
+#define P_IDLE		0		/* waiting for START */
+#define P_ADDR		1		/* receiving the address */
+#define P_WORD		2		/* receiving the word address */
+#define P_WDATA		3		/* receiving data */
+#define P_RDATA		4		/* sending data */
+#define P_IGNORE	5		/* not for us / NoACK, waiting for START or STOP */
+
+#define V_LOW		0
+#define V_HIGH		1
+#define V_SU_STA	2
+#define V_HD_STA	3
+#define V_SU_STO	4
+#define V_BUF		5
+#define V_SDA		6
+#define V_CONTENTION	7
+#define V_NACK		8
+#define V_COUNT		9
+
+static const char *const v_name[V_COUNT] = {
+	"SCL low < 4.7 us", "SCL high < 4.0 us", "repeated START setup < 4.7 us",
+	"START hold < 4.0 us", "STOP setup < 4.0 us", "bus free < 4.7 us",
+	"SDA changed inside a byte", "bus contention", "address not acknowledged"
+};
+
+#define KINDS		8
+
+/* transactions of the same shape, e.g. "W1R5" = 1 byte written, 5 read */
+typedef struct {
+	char sig[16];
+	uint32_t count;
+	uint64_t clocks;
+	uint64_t ns;
+} pcf_kind_t;
+
+static uint8_t reg[256];
+static uint8_t ptr;
+static uint8_t powered;			/* -s file read */
+static uint64_t base_ns;		/* time of reg[1..6] */
+
+static uint8_t scl = 1, sda = 1;	/* line levels */
+static uint8_t pull;			/* chip pulls SDA low */
+static uint8_t phase = P_IDLE, nbit, shreg, rw, mack;
+static uint64_t t_scl, t_sda, t_start, t_stop;	/* last edges */
+
+static uint8_t in_xfer, foreign, nwr, nrd;
+static uint64_t x_start, x_clocks;
+static char x_sig[16];
+
+static uint32_t v_count[V_COUNT];
+static uint64_t v_first[V_COUNT];
+static uint32_t v_pend[V_COUNT];	/* of the current transaction */
+static uint64_t v_pend_first[V_COUNT];
+static pcf_kind_t kinds[KINDS];
+static uint32_t n_xfer, n_empty;
+static uint64_t all_clocks, all_ns;
+
+extern uint8_t host_verbose;
+
+static void violation(uint8_t v)
+{
+	if (in_xfer) {			/* counted when the chip was addressed */
+		if (!v_pend[v]++)
+			v_pend_first[v] = host_ns();
+	} else if (!v_count[v]++) {
+		v_first[v] = host_ns();
+	}
+	if (host_verbose)
+		printf("pcf8583 %10.6f: %s\n", host_ns() / 1e9, v_name[v]);
+}
+
+static uint8_t bcd_inc(uint8_t *v, uint8_t max, uint8_t min)
+{
+	if (*v >= max) {
+		*v = min;
+		return (1);
+	}
+	*v = ((*v & 0x0f) == 9) ? (*v & 0xf0) + 0x10 : *v + 1;
+	return (0);
+}
+
+/*
+ * Count the hundredths elapsed since base_ns
+ */
+static void pcf_update(void)
+{
+	static const uint8_t mdays[13] = { 0, 0x31, 0x29, 0x31, 0x30, 0x31, 0x30,
+	    0x31, 0x31, 0x30, 0x31, 0x30, 0x31 };
+	uint64_t now = host_ns();
+	uint8_t hour, carry, date, month, year, days;
+
+	if (reg[0] & 0x80) {		/* counting stopped */
+		base_ns = now;
+		return;
+	}
+	while (now - base_ns >= HS_NS) {
+		base_ns += HS_NS;
+		if (!bcd_inc(&reg[1], 0x99, 0))
+			continue;
+		host_lat_second(base_ns);
+		if (!bcd_inc(&reg[2], 0x59, 0) || !bcd_inc(&reg[3], 0x59, 0))
+			continue;
+		hour = reg[4] & 0x3f;		/* 24 h format only */
+		carry = bcd_inc(&hour, 0x23, 0);
+		reg[4] = (reg[4] & 0xc0) | hour;
+		if (!carry)
+			continue;
+		date = reg[5] & 0x3f;
+		year = reg[5] >> 6;
+		month = reg[6] & 0x1f;
+		days = (month >= 1 && month <= 0x12) ? mdays[(month >> 4) * 10 + (month & 0x0f)] : 0x31;
+		if (month == 0x02 && year != 0)	/* year 0 is the leap year */
+			days = 0x28;
+		if (bcd_inc(&date, days, 1) && bcd_inc(&month, 0x12, 1))
+			year = (year + 1) & 3;
+		reg[5] = (uint8_t)(year << 6) | date;
+		reg[6] = (reg[6] & 0xe0) | month;
+	}
+}
+
+static uint8_t pcf_read(void)
+{
+	if (ptr >= 1 && ptr <= 6)
+		pcf_update();
+	return (reg[ptr++]);
+}
+
+static void pcf_write(uint8_t v)
+{
+	pcf_update();
+	reg[ptr] = v;
+	if (ptr == 1)			/* divider restarts with the hundredths */
+		base_ns = host_ns();
+	ptr++;
+}
+
+static void sig_add(char c, uint8_t n)
+{
+	size_t l = strlen(x_sig);
+
+	if (l + 4 < sizeof(x_sig))
+		snprintf(x_sig + l, sizeof(x_sig) - l, "%c%u", c, n);
+}
+
+static void xfer_begin(void)
+{
+	in_xfer = 1;
+	x_start = host_ns();
+	x_clocks = 0;
+	foreign = 0;
+	nwr = nrd = 0;
+	x_sig[0] = 0;
+}
+
+static void xfer_flush(void)
+{
+	if (nwr)
+		sig_add('W', nwr);
+	if (nrd)
+		sig_add('R', nrd);
+	nwr = nrd = 0;
+}
+
+static void xfer_end(void)
+{
+	uint64_t ns = host_ns() - x_start;
+	uint8_t i;
+
+	xfer_flush();
+	in_xfer = 0;
+	for (i = 0; i < V_COUNT; i++) {
+		if (v_pend[i] && !foreign) {
+			if (!v_count[i])
+				v_first[i] = v_pend_first[i];
+			v_count[i] += v_pend[i];
+		}
+		v_pend[i] = 0;
+	}
+	if (foreign)
+		return;			/* counted by the model of that chip */
+	if (!x_sig[0]) {
+		strcpy(x_sig, x_clocks ? "?" : "-");
+		n_empty += !x_clocks;
+	}
+	for (i = 0; i < KINDS && kinds[i].count && strcmp(kinds[i].sig, x_sig); i++)
+		;
+	if (i < KINDS) {
+		strcpy(kinds[i].sig, x_sig);
+		kinds[i].count++;
+		kinds[i].clocks += x_clocks;
+		kinds[i].ns += ns;
+	}
+	if (host_verbose)
+		printf("pcf8583 %10.6f: %-8s %3u clocks %7.1f us\n",
+		    x_start / 1e9, x_sig, (unsigned)x_clocks, ns / 1e3);
+	n_xfer++;
+	all_clocks += x_clocks;
+	all_ns += ns;
+}
+
+/*
+ * Byte received, 8th clock finished: ACK it
+ */
+static void rx_byte(void)
+{
+	if (phase == P_ADDR) {
+		if ((shreg & 0xfe) != PCF_ADDR) {
+			if (host_i2c_claimed(shreg & 0xfe))
+				foreign = 1;
+			else
+				violation(V_NACK);
+			phase = P_IGNORE;
+			return;
+		}
+		xfer_flush();
+		rw = shreg & 1;
+	} else if (phase == P_WORD) {
+		ptr = shreg;
+		nwr++;
+	} else {
+		pcf_write(shreg);
+		nwr++;
+	}
+	pull = 1;
+	nbit = 9;
+}
+
+/*
+ * Next byte to send, its MSB goes on SDA
+ */
+static void tx_next(void)
+{
+	shreg = pcf_read();
+	nrd++;
+	nbit = 0;
+	pull = !(shreg & 0x80);
+}
+
+static void scl_rise(uint64_t now)
+{
+	if (in_xfer && now - t_scl < T_LOW)
+		violation(V_LOW);
+	t_scl = now;
+	if (in_xfer)
+		x_clocks++;
+	if (phase == P_IDLE || phase == P_IGNORE)
+		return;
+	if (pull && !(host_port[HOST_D].tris & SDA_BIT) && (host_port[HOST_D].lat & SDA_BIT))
+		violation(V_CONTENTION);
+	if (phase == P_RDATA) {
+		if (nbit == 8)
+			mack = !sda;		/* master ACK is low */
+	} else if (nbit < 8) {
+		shreg = (uint8_t)(shreg << 1) | sda;
+		nbit++;
+	}
+}
+
+static void scl_fall(uint64_t now)
+{
+	if (in_xfer && now - t_scl < T_HIGH)
+		violation(V_HIGH);
+	if (in_xfer && x_clocks == 1 && now - t_start < T_HD_STA)
+		violation(V_HD_STA);
+	t_scl = now;
+	switch (phase) {
+	case P_RDATA:
+		if (nbit < 8) {
+			nbit++;
+			pull = nbit < 8 && !(shreg & (0x80 >> nbit));
+		} else if (mack) {
+			tx_next();
+		} else {
+			phase = P_IGNORE;	/* NoACK after the last byte */
+		}
+		break;
+	case P_ADDR:
+	case P_WORD:
+	case P_WDATA:
+		if (nbit == 8) {
+			rx_byte();
+		} else if (nbit == 9) {		/* ACK clock done */
+			pull = 0;
+			nbit = 0;
+			shreg = 0;
+			if (phase == P_ADDR && rw) {
+				phase = P_RDATA;
+				tx_next();
+			} else if (phase == P_ADDR) {
+				phase = P_WORD;
+			} else {
+				phase = P_WDATA;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void start(uint64_t now)
+{
+	if (in_xfer) {
+		if (now - t_scl < T_SU_STA)
+			violation(V_SU_STA);
+		if (nbit > 1 && nbit < 8)	/* the 1st clock precedes any START */
+			violation(V_SDA);
+	} else {
+		xfer_begin();
+		if (t_stop && now - t_stop < T_BUF)
+			violation(V_BUF);
+	}
+	t_start = now;
+	phase = P_ADDR;
+	nbit = 0;
+	shreg = 0;
+	pull = 0;
+}
+
+static void stop(uint64_t now)
+{
+	if (now - t_scl < T_SU_STO)
+		violation(V_SU_STO);
+	if (phase != P_IGNORE && nbit > 1 && nbit < 8)
+		violation(V_SDA);
+	if (in_xfer)
+		xfer_end();
+	phase = P_IDLE;
+	pull = 0;
+	t_stop = now;
+}
+
+/*
+ * Registers from the backup file (clock -s) or from the power-on reset
+ */
+static void pcf_power(void)
+{
+	FILE *fp;
+
+	if (powered)
+		return;
+	powered = 1;
+	if (!host_rtc_file || !(fp = fopen(host_rtc_file, "rb")))
+		return;
+	if (fread(reg, 1, sizeof(reg), fp) != sizeof(reg)) {
+		fprintf(stderr, "pcf8583: %s: short file\n", host_rtc_file);
+		exit(2);
+	}
+	fclose(fp);
+	base_ns = host_ns();
+}
+
+/*
+ * Registers to the backup file at the end of the run
+ */
+static void pcf_backup(void)
+{
+	FILE *fp;
+
+	if (!host_rtc_file)
+		return;
+	if (!(fp = fopen(host_rtc_file, "wb")) ||
+	    fwrite(reg, 1, sizeof(reg), fp) != sizeof(reg) || fclose(fp)) {
+		fprintf(stderr, "pcf8583: %s: cannot write\n", host_rtc_file);
+		return;
+	}
+	printf("pcf8583: registers saved to %s\n", host_rtc_file);
+}
+
+/*
+ * Pins of port D changed: decode the bus
+ */
+static void pcf_out(uint8_t port)
+{
+	uint8_t lat = host_port[HOST_D].lat, tris = host_port[HOST_D].tris;
+	uint8_t c, d;
+	uint64_t now;
+
+	if (port != HOST_D)
+		return;
+	pcf_power();
+	now = host_ns();
+	c = (tris & SCL_BIT) ? 1 : !!(lat & SCL_BIT);
+	d = ((tris & SDA_BIT) ? 1 : !!(lat & SDA_BIT)) && !pull;
+	if (c == scl && d != sda) {
+		t_sda = now;
+		sda = d;
+		if (c) {
+			if (d)
+				stop(now);
+			else
+				start(now);
+		}
+	} else if (c != scl) {
+		sda = d;
+		scl = c;
+		if (c)
+			scl_rise(now);
+		else
+			scl_fall(now);
+	}
+	/* own ACK / data bit appears on SDA */
+	sda = ((tris & SDA_BIT) ? 1 : !!(lat & SDA_BIT)) && !pull;
+}
+
+static uint8_t pcf_in(uint8_t port, uint8_t pins)
+{
+	pcf_power();
+	if (port == HOST_D && pull)
+		return (pins & ~SDA_BIT);
+	if (port == HOST_B && !(reg[0] & 0x80)) {
+		pcf_update();
+		if (reg[1] < 0x50)		/* INT low in the first half second */
+			return (pins & ~INT_BIT);
+	}
+	return (pins);
+}
+
+static uint64_t pcf_next(void)
+{
+	uint8_t hs;
+
+	pcf_power();
+	if (reg[0] & 0x80)
+		return (UINT64_MAX);
+	pcf_update();
+	hs = (reg[1] >> 4) * 10 + (reg[1] & 0x0f);
+	return (host_at_ns(base_ns + (uint64_t)((hs < 50 ? 50 : 100) - hs) * HS_NS));
+}
+
+static void pcf_report(void)
+{
+	uint8_t i;
+
+	printf("pcf8583: %u transactions (%u empty), %llu SCL clocks, bus busy %.3f ms\n",
+	    n_xfer, n_empty, (unsigned long long)all_clocks, all_ns / 1e6);
+	for (i = 0; i < KINDS && kinds[i].count; i++)
+		printf("pcf8583:   %-8s x%-6u %5.1f clocks %8.1f us each\n", kinds[i].sig,
+		    kinds[i].count, (double)kinds[i].clocks / kinds[i].count,
+		    kinds[i].ns / 1e3 / kinds[i].count);
+	for (i = 0; i < V_COUNT; i++)
+		if (v_count[i])
+			printf("pcf8583: violation: %s, %u times, first at %.6f s\n",
+			    v_name[i], v_count[i], v_first[i] / 1e9);
+	pcf_update();
+	printf("pcf8583: time %02x:%02x:%02x.%02x, control %02x\n",
+	    reg[4] & 0x3f, reg[3], reg[2], reg[1], reg[0]);
+	pcf_backup();
+}
+
+static host_model_t pcf_model = {
+	"pcf8583", pcf_out, pcf_in, pcf_next, pcf_report, NULL
+};
+
+__attribute__((constructor)) static void pcf_attach(void)
+{
+	reg[5] = 0x01;			/* 1 January */
+	reg[6] = 0x01;
+	host_attach(&pcf_model);
+}
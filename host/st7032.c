@@ -0,0 +1,383 @@
+/*
+ * File:   st7032.c
+ *
+ * Model of the HD44780 compatible ST7032 LCD controller on PORTC (host
+ * build): RC0..RC3 = DB4..DB7, RC4 = EN, RC5 = RW, RC6 = RS. Every falling
+ * edge of EN with RW low latches the nibble and RS present while EN was
+ * high; the controller starts in 8 bit mode until a function set with
+ * DL = 0 switches it to nibble pairs. Reads (RW high) return the busy flag
+ * and the address counter.
+ *
+ * The model keeps DDRAM, CGRAM, ICON RAM, the address counter, entry mode,
+ * display control and the ST7032 extended instruction table (IS = 1:
+ * oscillator, ICON address, power/ICON/contrast, follower, contrast), and
+ * times every instruction. A write while the previous one still executes
+ * is a violation, as are a short EN pulse, a DDRAM address outside the
+ * 2 line map and display on before the follower circuit settled.
+ *
+ * Writes are grouped into frames (a burst separated by LCDM_GAP_US of
+ * silence); each frame is measured in data bytes, commands and busy time
+ * of the controller. clock -v prints every frame with the screen.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define EN_BIT		0x10
+#define RW_BIT		0x20
+#define RS_BIT		0x40
+
+/*
+ * Execution times in ns, HD44780 at 270 kHz (worst case). The ST7032
+ * at 380 kHz is faster (26.3 us / 1.08 ms), e.g. HOST_FLAGS=-DLCDM_T_CMD=26300
+ */
+#ifndef LCDM_T_CMD
+#define LCDM_T_CMD	37000		/* most instructions */
+#endif
+#ifndef LCDM_T_DATA
+#define LCDM_T_DATA	41000		/* data write, incl. address update */
+#endif
+#ifndef LCDM_T_CLEAR
+#define LCDM_T_CLEAR	1520000		/* clear display, return home */
+#endif
+#define T_POWER		40000000ULL	/* power on to the first instruction */
+#define T_FOLLOWER	200000000ULL	/* follower on to display on */
+#define T_PW		450		/* EN high, 3 V supply */
+
+#ifndef LCDM_GAP_US
+#define LCDM_GAP_US	10000		/* silence ending a frame */
+#endif
+#define LCDM_COLS	16		/* visible characters per line */
+
+#define V_BUSY		0
+#define V_PW		1
+#define V_ADDR		2
+#define V_SETTLE	3
+#define V_COUNT		4
+
+static const char *const v_name[V_COUNT] = {
+	"write while busy", "EN pulse < 450 ns", "DDRAM address outside 00-27/40-67",
+	"display on < 200 ms after follower on"
+};
+
+/* controller */
+static uint8_t ddram[128], cgram[64], icon[16];
+static uint8_t ac;			/* address counter */
+static uint8_t ram;			/* 0 DDRAM, 1 CGRAM, 2 ICON RAM */
+static uint8_t shift;			/* display shift, 0..39 */
+static uint8_t entry = 0x02;		/* I/D, S */
+static uint8_t dctl;			/* D, C, B */
+static uint8_t fn = 0x10;		/* DL, N, DH, IS: 8 bit after reset */
+static uint8_t osc, pwr, follower, contrast;
+static uint64_t t_follower;
+
+/* interface */
+static uint8_t lines;			/* RC0..RC6 as driven */
+static uint8_t hi, half;		/* first nibble of a pair */
+static uint8_t rd_half;			/* next read nibble is AC3..0 */
+static uint64_t t_en, busy_until = T_POWER;
+
+/* statistics */
+typedef struct {
+	uint32_t bytes, cmds;
+	uint64_t busy, start, end;
+} frame_t;
+
+static frame_t f, f_init, f_max, f_sum;
+static uint32_t n_frames;		/* frames after the init frame */
+static uint8_t in_frame;
+static uint32_t v_count[V_COUNT];
+static uint64_t v_first[V_COUNT], v_early;
+static uint64_t t_text;			/* first DDRAM change */
+static uint64_t t_visible;		/* first text with the display on */
+
+extern uint8_t host_verbose;
+
+static void violation(uint8_t v)
+{
+	if (!v_count[v]++)
+		v_first[v] = host_ns();
+	if (host_verbose)
+		printf("st7032  %10.6f: %s\n", host_ns() / 1e9, v_name[v]);
+}
+
+/*
+ * Line n of the display as shown (shift applied)
+ */
+static void screen(uint8_t n, char *s)
+{
+	uint8_t i, c;
+
+	for (i = 0; i < LCDM_COLS; i++) {
+		c = ddram[(n ? 0x40 : 0) + (i + shift) % 40];
+		s[i] = (c >= 0x20 && c < 0x7f) ? c : '.';
+	}
+	s[i] = 0;
+}
+
+static void frame_end(void)
+{
+	char l1[LCDM_COLS + 1], l2[LCDM_COLS + 1];
+
+	if (!in_frame)
+		return;
+	in_frame = 0;
+	if (host_verbose) {
+		screen(0, l1);
+		screen(1, l2);
+		printf("st7032  %10.6f: %3u bytes %2u cmds %8.1f us busy |%s|%s|\n",
+		    f.start / 1e9, f.bytes, f.cmds, f.busy / 1e3, l1, l2);
+	}
+	if (!f_init.start) {		/* the first frame initializes the LCD */
+		f_init = f;
+		return;
+	}
+	n_frames++;
+	f_sum.bytes += f.bytes;
+	f_sum.cmds += f.cmds;
+	f_sum.busy += f.busy;
+	f_sum.end += f.end - f.start;
+	if (f.bytes > f_max.bytes)
+		f_max.bytes = f.bytes;
+	if (f.cmds > f_max.cmds)
+		f_max.cmds = f.cmds;
+	if (f.busy > f_max.busy)
+		f_max.busy = f.busy;
+	if (f.end - f.start > f_max.end)
+		f_max.end = f.end - f.start;
+}
+
+/*
+ * Address counter after a DDRAM access
+ */
+static void ac_step(void)
+{
+	if (ram) {
+		ac = (entry & 0x02) ? ac + 1 : ac - 1;
+		return;
+	}
+	if (!(fn & 0x08)) {			/* 1 line: 00-4F */
+		if (entry & 0x02)
+			ac = (ac == 0x4f) ? 0 : ac + 1;
+		else
+			ac = ac ? ac - 1 : 0x4f;
+	} else if (entry & 0x02) {		/* 2 lines: 00-27, 40-67 */
+		ac = (ac == 0x27) ? 0x40 : (ac == 0x67) ? 0 : ac + 1;
+	} else {
+		ac = (ac == 0x40) ? 0x27 : (ac == 0) ? 0x67 : ac - 1;
+	}
+	ac &= 0x7f;
+	if ((entry & 0x01))			/* display follows the cursor */
+		shift = (entry & 0x02) ? (shift + 1) % 40 : (shift + 39) % 40;
+}
+
+/*
+ * Execute an instruction, returns its execution time
+ */
+static uint32_t command(uint8_t c, uint64_t now)
+{
+	if (c & 0x80) {				/* set DDRAM address */
+		ac = c & 0x7f;
+		ram = 0;
+		if ((fn & 0x08) && ((ac > 0x27 && ac < 0x40) || ac > 0x67))
+			violation(V_ADDR);
+	} else if ((c & 0xe0) == 0x20) {	/* function set */
+		fn = c & 0x1f;
+		if (!(fn & 0x10))
+			half = 0;		/* 4 bit mode, pairs from now */
+	} else if (c & 0x40 && !(fn & 0x01)) {	/* set CGRAM address */
+		ac = c & 0x3f;
+		ram = 1;
+	} else if (c & 0x40) {			/* extended instructions */
+		switch (c & 0x30) {
+		case 0x00:			/* ICON address */
+			ac = c & 0x0f;
+			ram = 2;
+			break;
+		case 0x10:			/* power, ICON, contrast C5 C4 */
+			pwr = (c >> 2) & 0x03;
+			contrast = (contrast & 0x0f) | ((c & 0x03) << 4);
+			break;
+		case 0x20:			/* follower */
+			if ((c & 0x08) && !(follower & 0x08))
+				t_follower = now;
+			follower = c & 0x0f;
+			break;
+		default:			/* contrast C3..C0 */
+			contrast = (contrast & 0x30) | (c & 0x0f);
+			break;
+		}
+	} else if (c & 0x10 && (fn & 0x01)) {	/* oscillator frequency */
+		osc = c & 0x0f;
+	} else if (c & 0x10) {			/* cursor or display shift */
+		if (c & 0x08)
+			shift = (c & 0x04) ? (shift + 39) % 40 : (shift + 1) % 40;
+		else
+			ac = (c & 0x04) ? (ac + 1) & 0x7f : (ac - 1) & 0x7f;
+	} else if (c & 0x08) {			/* display control */
+		if ((c & 0x04) && !(dctl & 0x04) && (follower & 0x08)
+		    && now - t_follower < T_FOLLOWER)
+			violation(V_SETTLE);
+		dctl = c & 0x07;
+		if (t_text && !t_visible && (dctl & 0x04))
+			t_visible = now;
+	} else if (c & 0x04) {			/* entry mode */
+		entry = c & 0x03;
+	} else if (c & 0x02) {			/* return home */
+		ac = 0;
+		ram = 0;
+		shift = 0;
+		return (LCDM_T_CLEAR);
+	} else if (c) {				/* clear display */
+		memset(ddram, ' ', sizeof(ddram));
+		ac = 0;
+		ram = 0;
+		shift = 0;
+		entry |= 0x02;
+		return (LCDM_T_CLEAR);
+	}
+	return (LCDM_T_CMD);
+}
+
+static uint32_t data(uint8_t c)
+{
+	if (ram == 1)
+		cgram[ac & 0x3f] = c;
+	else if (ram == 2)
+		icon[ac & 0x0f] = c;
+	else if (ddram[ac] != c) {
+		ddram[ac] = c;
+		if (!t_text)
+			t_text = host_ns();
+		if (!t_visible && (dctl & 0x04))
+			t_visible = host_ns();
+		host_lat_ddram(ac);
+	}
+	ac_step();
+	return (LCDM_T_DATA);
+}
+
+/*
+ * EN fell with RW low: latch a nibble
+ */
+static void strobe(uint8_t l, uint64_t now)
+{
+	uint8_t c;
+	uint32_t t;
+
+	if (now < busy_until) {
+		violation(V_BUSY);
+		if (busy_until - now > v_early)
+			v_early = busy_until - now;
+	}
+	if (in_frame && now - f.end > LCDM_GAP_US * 1000ULL)
+		frame_end();
+	if (!in_frame) {
+		memset(&f, 0, sizeof(f));
+		f.start = now;
+		in_frame = 1;
+	}
+	rd_half = 0;
+	if (!(fn & 0x10) && !half) {		/* 4 bit mode, high nibble */
+		hi = l & 0x0f;
+		half = 1;
+		f.end = now;
+		return;
+	}
+	c = (fn & 0x10) ? (l & 0x0f) << 4 : (hi << 4) | (l & 0x0f);
+	half = 0;
+	if (l & RS_BIT) {
+		t = data(c);
+		f.bytes++;
+	} else {
+		t = command(c, now);
+		f.cmds++;
+	}
+	busy_until = now + t;
+	f.busy += t;
+	f.end = busy_until;
+}
+
+/*
+ * PORTC changed: EN edges
+ */
+static void lcd_out(uint8_t port)
+{
+	uint8_t l;
+	uint64_t now;
+
+	if (port != HOST_C)
+		return;
+	l = host_port[HOST_C].lat & ~host_port[HOST_C].tris & 0x7f;
+	now = host_ns();
+	if ((l & EN_BIT) && !(lines & EN_BIT)) {
+		t_en = now;
+	} else if (!(l & EN_BIT) && (lines & EN_BIT)) {
+		if (now - t_en < T_PW)
+			violation(V_PW);
+		if (lines & RW_BIT)		/* read: next nibble */
+			rd_half = (fn & 0x10) ? 0 : !rd_half;
+		else				/* data and RS as held while EN was high */
+			strobe(lines, now);
+	}
+	lines = l;
+}
+
+/*
+ * Read with EN high: busy flag and address counter on DB7..DB4
+ */
+static uint8_t lcd_in(uint8_t port, uint8_t pins)
+{
+	uint8_t v;
+
+	if (port != HOST_C || (lines & (EN_BIT | RW_BIT)) != (EN_BIT | RW_BIT))
+		return (pins);
+	if (lines & RS_BIT)			/* data read is not used */
+		return (pins);
+	v = rd_half ? ac & 0x0f : ((host_ns() < busy_until) << 3) | (ac >> 4);
+	return ((pins & 0xf0) | v);
+}
+
+static void lcd_report(void)
+{
+	char l1[LCDM_COLS + 1], l2[LCDM_COLS + 1];
+	uint8_t i;
+
+	frame_end();
+	printf("st7032: init %u bytes %u cmds, busy %.1f us, done at %.3f ms\n",
+	    f_init.bytes, f_init.cmds, f_init.busy / 1e3, f_init.end / 1e6);
+	if (t_text)
+		printf("st7032: boot to first text %.3f ms, visible at %.3f ms\n",
+		    t_text / 1e6, t_visible / 1e6);
+	if (n_frames)
+		printf("st7032: %u frames, per frame avg/max: %.1f/%u bytes, %.1f/%u cmds, "
+		    "busy %.1f/%.1f us, span %.1f/%.1f us\n", n_frames,
+		    (double)f_sum.bytes / n_frames, f_max.bytes,
+		    (double)f_sum.cmds / n_frames, f_max.cmds,
+		    f_sum.busy / 1e3 / n_frames, f_max.busy / 1e3,
+		    f_sum.end / 1e3 / n_frames, f_max.end / 1e3);
+	for (i = 0; i < V_COUNT; i++)
+		if (v_count[i])
+			printf("st7032: violation: %s, %u times, first at %.6f s\n",
+			    v_name[i], v_count[i], v_first[i] / 1e9);
+	if (v_count[V_BUSY])
+		printf("st7032: worst write %.1f us before ready\n", v_early / 1e3);
+	screen(0, l1);
+	screen(1, l2);
+	printf("st7032: |%s| display %s, cursor %02x, contrast %u, follower %x, osc %x\n",
+	    l1, (dctl & 0x04) ? "on" : "off", ac, contrast, follower, osc);
+	printf("st7032: |%s|\n", l2);
+}
+
+static host_model_t lcd_model = {
+	"st7032", lcd_out, lcd_in, NULL, lcd_report, NULL
+};
+
+__attribute__((constructor)) static void lcd_attach(void)
+{
+	memset(ddram, ' ', sizeof(ddram));
+	host_attach(&lcd_model);
+}
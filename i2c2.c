@@ -1,48 +1,185 @@
-#include <pic18f46k22.h>
+/*
+ * File:   i2c2.c
+ *
+ * Bit-banged I2C master on RD0 = SCL, RD1 = SDA (I2C_USE_MSSP = 0) and
+ * I2C_Read_Block() / I2C_Write_Block() / I2C_Write_Block_W() shared with
+ * the MSSP backend. The lines are driven
+ * open drain: LATD0/LATD1 stay 0, a line is pulled low by its TRIS bit = 0
+ * and released to the pull-up by TRIS = 1, so a slave can hold SCL low
+ * (clock stretching) or SDA low (ACK, data) without bus contention.
+ *
+ * The SCL low and high times are Tcy counts derived from _XTAL_FREQ for
+ * 100 kHz, devices with I2C_SPEED_FAST run at I2C_SOFT_SPEED. After every
+ * SCL release the driver waits until the line is really high, at most
+ * I2C_SOFT_TIMEOUT_US. A timeout or SDA held low by somebody else makes
+ * the rest of the transaction a no-op, I2C_Stop() then frees the bus by up
+ * to 9 clocks and a STOP. A bad transaction therefore blocks for at most
+ * two timeouts plus 10 SCL periods (~1.1 ms with the defaults).
+ */
+
+#include "hal.h"
 
 #include "avr/io.h"
 #include "i2c2.h"
 
 
+#if !I2C_USE_MSSP
+#define I2C_SCL_REL()	hal_pin_dir(D, 0, 1)	/* released, pull-up makes it high */
+#define I2C_SCL_LOW()	hal_pin_dir(D, 0, 0)	/* LATD0 = 0 pulls it low */
+#define I2C_SDA_REL()	hal_pin_dir(D, 1, 1)
+#define I2C_SDA_LOW()	hal_pin_dir(D, 1, 0)
+#define I2C_SCL_IN()	hal_pin_read(D, 0)
+#define I2C_SDA_IN()	hal_pin_read(D, 1)
+
+/* SCL low / high times in ns (a full period of the rate, at least tLOW / tHIGH) */
+#define I2C_STD_LOW	5000
+#define I2C_STD_HIGH	5000
+#if I2C_SOFT_SPEED > 100000UL
+#define I2C_FAST_LOW	1500
+#define I2C_FAST_HIGH	1000
+#else
+#define I2C_FAST_LOW	I2C_STD_LOW
+#define I2C_FAST_HIGH	I2C_STD_HIGH
+#endif
+
+#define I2C_MHZ		(_XTAL_FREQ / 4000000UL)	/* Tcy per us */
+#define I2C_OVH		2	/* Tcy of pin access besides the wait, at least */
+#define I2C_CY(ns)	((ns) * (_XTAL_FREQ / 4000UL) / 1000000UL + 1)
+#define I2C_DELAY(ns)	hal_delay_cy(I2C_CY(ns) > I2C_OVH ? I2C_CY(ns) - I2C_OVH : 1)
+#define I2C_POLL_OVH	8	/* Tcy of one SCL poll besides its 1 us delay */
+#define I2C_POLLS	(uint16_t)(I2C_SOFT_TIMEOUT_US * I2C_MHZ / (I2C_MHZ + I2C_POLL_OVH))
+
+static uint8_t i2c_fast;			/* timing of I2C_SPEED_FAST */
+static uint8_t i2c_busy;			/* between START and STOP */
+static uint8_t i2c_err = I2C_ERR_NONE;		/* of the current transaction */
+
 /*!
- * \brief Wait function for I2C
+ * \brief Wait function for I2C, SCL low time of the selected speed
  */
+void I2C_Wait(void)
+{
+	if (i2c_fast)
+		I2C_DELAY(I2C_FAST_LOW);
+	else
+		I2C_DELAY(I2C_STD_LOW);
+}
 
-void I2C_Wait() 
+/*!
+ * \brief Function waits the SCL high time of the selected speed
+ */
+static void I2C_Wait_High(void)
 {
-        uint8_t cnt = 10;
-        while (--cnt);
+	if (i2c_fast)
+		I2C_DELAY(I2C_FAST_HIGH);
+	else
+		I2C_DELAY(I2C_STD_HIGH);
 }
 
+/*!
+ * \brief Function releases SCL and waits until a stretching slave lets it go
+ *
+ * \return 0	Err, SCL still low after I2C_SOFT_TIMEOUT_US
+ * \return 1	OK,  SCL is high
+ */
+static uint8_t I2C_Scl_High(void)
+{
+	uint16_t n = I2C_POLLS;
 
+	I2C_SCL_REL();
+	while (!I2C_SCL_IN()) {
+		if (!--n)
+			return (0);
+		hal_delay_us(1);
+	}
+	return (1);
+}
 
 /*!
- * \brief Function sets high part of address
- *
- * \param adr	Low part of address
- * \param func	Type of operation (0 - write, 1 - read)
+ * \brief Function generates one SCL pulse with SDA set up by the caller
  *
+ * \return	SDA level while SCL is high, 1 after a timeout
+ */
+static uint8_t I2C_Clock(void)
+{
+	uint8_t sda;
+
+	I2C_Wait();
+	if (!I2C_Scl_High()) {
+		i2c_err = I2C_ERR_TIMEOUT;
+		return (1);
+	}
+	I2C_Wait_High();
+	sda = I2C_SDA_IN();
+	I2C_SCL_LOW();
+	return (sda);
+}
+
+/*!
+ * \brief Function frees the bus: clocks until a slave stuck in a byte
+ * releases SDA (9 at most), then STOP
  */
- void I2C_Set_Address(uint8_t adr, uint8_t func)
+static void I2C_Recover(void)
+{
+	uint8_t cnt = 9;
 
+	I2C_SDA_REL();
+	I2C_SCL_LOW();
+	while (!I2C_SDA_IN() && cnt--) {
+		I2C_Wait();
+		if (!I2C_Scl_High())
+			return;				/* SCL stuck low, nothing to do */
+		I2C_Wait_High();
+		I2C_SCL_LOW();
+	}
+	I2C_SDA_LOW();
+	I2C_Wait();
+	if (!I2C_Scl_High())
+		return;
+	I2C_Wait_High();
+	I2C_SDA_REL();					/* STOP */
+	if (!I2C_SDA_IN())
+		i2c_err = I2C_ERR_BUS;
+}
+
+/*!
+ * \brief Function releases RD0/RD1 and frees the bus if a slave holds it
+ */
+void I2C_Init(void)
 {
-	I2C_Start();					/* Generate start condition */
-	/* ** Do you want to write ? */
-	if (!func) {
-		I2C_Write_B(0xa0);			/* <Y> Write chip address and operation WRITE */
-                I2C_Write_B(adr);				/* Write low address */
-        }
-	else
-		I2C_Write_B(0xa1);			/* <N> Write chip address and operation READ */
+	I2C_SDA_REL(); I2C_SCL_REL();			/* SDA first, no STOP on the bus */
+	hal_pin_write(D, 0, 0); hal_pin_write(D, 1, 0);	/* open drain: pins only go low */
+	i2c_busy = 0;
+	i2c_err = I2C_ERR_NONE;
+	if (!I2C_SCL_IN() || !I2C_SDA_IN())
+		I2C_Recover();
+}
 
-	
+/*!
+ * \brief Function selects the bus speed
+ *
+ * \param speed	I2C_SPEED_STD (100 kHz) / I2C_SPEED_FAST (I2C_SOFT_SPEED)
+ */
+void I2C_Speed(uint8_t speed)
+{
+	i2c_fast = (speed == I2C_SPEED_FAST);
+}
+
+/*!
+ * \brief Function returns the error of the last transaction
+ *
+ * \return	I2C_ERR_NONE, I2C_ERR_TIMEOUT, I2C_ERR_BUS
+ */
+uint8_t I2C_Error(void)
+{
+	return (i2c_err);
 }
+#endif
 
 /*!
  * \brief Function reads block of <I>i</I> data from I2C and store them to <B>*p_dta</B>
  *
- * \param	i		Number of byte for reading 
- * \param	*p_dta		Pointer to the memory for writting 
+ * \param	i		Number of byte for reading
+ * \param	*p_dta		Pointer to the memory for writting
  */
 void I2C_Read_Block(uint8_t i, uint8_t *p_dta)
 {
@@ -58,91 +195,170 @@ void I2C_Read_Block(uint8_t i, uint8_t *p_dta)
 }
 
 /*!
- * \brief Function generates START condition on I2C
+ * \brief Function writes block of <I>i</I> data from <B>*p_dta</B> to I2C, every byte
+ * must be acknowledged, the first NoACK ends the block
  *
+ * \param	i		Number of byte for writing
+ * \param	*p_dta		Pointer to the data
+ * \return 0	Err, NoACK from I2C device or bus error
+ * \return 1	OK,  all bytes acknowledged
  */
-void I2C_Start(void)
+uint8_t I2C_Write_Block(uint8_t i, const uint8_t *p_dta)
 {
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 0;					/* Set pins direction to output */
+	uint8_t ok = 1;
 
-	LATDbits.LATD0 = 1;					/* SDA must go down during SCL is high */
-	I2C_Wait();	/* wait */ 	
-	LATDbits.LATD1 = 1;
-	I2C_Wait();	/* wait */ 	
-	LATDbits.LATD1 = 0;
-	I2C_Wait();	/* wait */ 
-	LATDbits.LATD0 = 0;
+	while (ok && i--)
+		ok = I2C_Write_B_Ack(*p_dta++);
+	I2C_Stop();					/* Generate STOP condition */
+	return (ok);
 }
 
 /*!
- * \brief Function generates STOP condition on I2C
+ * \brief Function writes block of <I>i</I> words from <B>*p_dta</B> to I2C, MSB first,
+ * every byte must be acknowledged
  *
+ * \param	i		Number of words for writing
+ * \param	*p_dta		Pointer to the data
+ * \return 0	Err, NoACK from I2C device or bus error
+ * \return 1	OK,  all bytes acknowledged
  */
-void I2C_Stop(void)
+uint8_t I2C_Write_Block_W(uint8_t i, const uint16_t *p_dta)
 {
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 0;					/* Set pins direction to output */
+	uint8_t ok = 1;
 
-	LATDbits.LATD1 = 0;					/* SDA must go up during SCL is high */
-	I2C_Wait();	/* wait */ 
-	LATDbits.LATD0 = 0;
-	I2C_Wait();	/* wait */ 
-	LATDbits.LATD0 = 1;
-	I2C_Wait();	/* wait */ 
-	LATDbits.LATD1 = 1;
+	for (; ok && i; i--, p_dta++) {
+		ok = I2C_Write_B_Ack(*p_dta >> 8);
+		if (ok)
+			ok = I2C_Write_B_Ack((uint8_t)*p_dta);
+	}
+	I2C_Stop();					/* Generate STOP condition */
+	return (ok);
 }
 
+#if !I2C_USE_MSSP
 /*!
- * \brief Function writes one byte to I2C and it generates ACK pulse WITHOUT ACK checking
+ * \brief Function generates START condition on I2C, inside a transaction
+ * (SCL low) it is a repeated START. A START on an idle bus begins a new
+ * transaction and clears the error, a bus held low is recovered first.
+ *
+ */
+void I2C_Start(void)
+{
+	if (!i2c_busy) {
+		i2c_err = I2C_ERR_NONE;
+		if (!I2C_SCL_IN() || !I2C_SDA_IN())
+			I2C_Recover();
+		if (i2c_err)
+			return;
+		I2C_Wait();				/* bus free time since the last STOP */
+	} else {
+		if (i2c_err)
+			return;
+		I2C_SDA_REL();				/* SDA up first, SCL up with SDA low would be STOP */
+		I2C_Wait();
+		if (!I2C_Scl_High()) {
+			i2c_err = I2C_ERR_TIMEOUT;
+			return;
+		}
+		I2C_Wait_High();			/* repeated START setup */
+	}
+	i2c_busy = 1;
+	I2C_SDA_LOW();					/* SDA must go down during SCL is high */
+	I2C_Wait_High();				/* START hold */
+	I2C_SCL_LOW();
+}
+
+/*!
+ * \brief Function generates STOP condition on I2C, after an error it
+ * recovers the bus instead
+ *
+ */
+void I2C_Stop(void)
+{
+	if (i2c_err) {
+		i2c_busy = 0;
+		I2C_Recover();
+		return;
+	}
+	if (!i2c_busy)
+		return;					/* bus is free already */
+	i2c_busy = 0;
+	I2C_SDA_LOW();					/* SDA must go up during SCL is high */
+	I2C_Wait();
+	if (!I2C_Scl_High()) {
+		i2c_err = I2C_ERR_TIMEOUT;
+		I2C_Recover();
+		return;
+	}
+	I2C_Wait_High();				/* STOP setup */
+	I2C_SDA_REL();
+}
+
+/*!
+ * \brief Function shifts out 8 bits of one byte, MSB first. A 1 read back
+ * as 0 means another master or a stuck slave holds SDA.
  *
  * \param dta	Data for writing
  */
-void I2C_Write_B (uint8_t dta)
+static void I2C_Shift_Out(uint8_t dta)
 {
 	uint8_t	cnt = 8;
-	do							/* Send one byte to I2C */
-	{
-		LATDbits.LATD1 = (dta & 0x80)? 1 : 0;		/* Set MSB bit to SDA */
-		I2C_Wait();	/* wait */ 
-		LATDbits.LATD0 = 1;
-		I2C_Wait();	/* wait */ 
-		LATDbits.LATD0 = 0;
+
+	do {						/* Send one byte to I2C */
+		if (dta & 0x80)
+			I2C_SDA_REL();			/* Set MSB bit to SDA */
+		else
+			I2C_SDA_LOW();
+		if (!I2C_Clock() && (dta & 0x80))
+			i2c_err = I2C_ERR_BUS;
+		if (i2c_err)
+			return;
 		dta <<= 1;
 	} while (--cnt);
-	/*  Generation of ACK pulse ---- <br> WITHOUT ACK checking </b> */
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 1;						/* Set SDA to input */
+}
 
-	LATDbits.LATD0 = 1;
-	I2C_Wait();	/* wait */ 
-	LATDbits.LATD0 = 0;
-	I2C_Wait();	/* wait */ 
+/*!
+ * \brief Function writes one byte to I2C, the ACK of the slave is clocked but not tested
+ *
+ * \param dta	Data for writing
+ */
+void I2C_Write_B (uint8_t dta)
+{
+	(void)I2C_Write_B_Ack(dta);
+}
 
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 0;						/* Set SDA to output */
+/*!
+ * \brief Function writes one byte to I2C and tests the ACK pulse of the slave
+ *
+ * \param dta	Data for writing
+ * \return 0	Err, NoACK from I2C device or bus error
+ * \return 1	OK,  ACK from I2C device
+ */
+uint8_t I2C_Write_B_Ack(uint8_t dta)
+{
+	if (i2c_err)
+		return (0);
+	I2C_Shift_Out(dta);
+	return (I2C_Ack_In());					/* ACK clock pulse with checking */
 }
 
 /*!
  * \brief Function reads one byte from I2C and generates an ACK condition
  *
  * \param 	ack	Type of ACK, 0 .. NoACK, 1 .. Ack
- * \return	dta	Read value
+ * \return	dta	Read value, 0xff after a bus error
  */
 uint8_t I2C_Read_B (uint8_t ack)
 {
 	uint8_t dta = 0;
 	uint8_t cnt = 8;
 
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 1;						/* Set SDA to input */
-        I2C_Wait();
-	do
-	{
-		LATDbits.LATD0 = 1;					/* Generate clock pulse */
-		dta <<= 1;
-                I2C_Wait();
-		dta |= PORTDbits.RD1 ? 1 : 0;	/* Read one bit from I2C */
-        LATDbits.LATD0 = 0;
-                I2C_Wait();
-	} while (--cnt);
-
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 0;	
+	if (i2c_err)
+		return (0xff);
+	I2C_SDA_REL();						/* SDA belongs to the slave */
+	do {
+		dta = (dta << 1) | I2C_Clock();			/* Read one bit from I2C */
+	} while (--cnt && !i2c_err);
 	/* ** Do we have to generate ACK ? */
 	if (ack)
 		I2C_Ack_Out();					/* <Y> Generate ACK */
@@ -154,20 +370,18 @@ uint8_t I2C_Read_B (uint8_t ack)
 /*!
  * \brief Function tests ACK pulse generated on I2C
  *
- * \return 0	Err, NoACK from I2C device
+ * \return 0	Err, NoACK from I2C device or bus error
  * \return 1	OK,  ACK from I2C device
  */
 uint8_t I2C_Ack_In(void)
 {
 	uint8_t stat;
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 1;                                             /* Set SDA as input */
 
-	LATDbits.LATD0 = 1;                                               /* Generation CLK pulse */
-	I2C_Wait();	        /* wait */ 
-	stat = PORTDbits.RD1 ? 0 : 1;
-	LATDbits.LATD0 = 0;
-	TRISDbits.TRISD0 = 0; TRISDbits.TRISD1 = 0;                                            /* Set SDA as output */
-	return (stat);
+	if (i2c_err)
+		return (0);
+	I2C_SDA_REL();						/* SDA belongs to the slave */
+	stat = I2C_Clock() ? 0 : 1;
+	return (i2c_err ? 0 : stat);
 }
 
 /*!
@@ -175,12 +389,10 @@ uint8_t I2C_Ack_In(void)
  */
 void I2C_NoAck_Out(void)
 {
-	LATDbits.LATD1 = 1;
-	I2C_Wait();	        /* wait */ 
-	LATDbits.LATD0 = 1;
-	I2C_Wait();	        /* wait */ 
-	LATDbits.LATD0 = 0;
-
+	if (i2c_err)
+		return;
+	I2C_SDA_REL();
+	(void)I2C_Clock();
 }
 
 /*!
@@ -188,11 +400,10 @@ void I2C_NoAck_Out(void)
  */
 void I2C_Ack_Out(void)
 {
-	LATDbits.LATD1 = 0;
-	I2C_Wait();	        /* wait */ 
-	LATDbits.LATD0 = 1;
-	I2C_Wait();	        /* wait */ 
-	LATDbits.LATD0 = 0;
-
+	if (i2c_err)
+		return;
+	I2C_SDA_LOW();
+	(void)I2C_Clock();
+	I2C_SDA_REL();
 }
-
+#endif /* !I2C_USE_MSSP */
@@ -3,16 +3,31 @@
 
 #include "avr/io.h"
 #include "shift.h"
+#include "config.h"
 
-void I2C_Set_Address(uint8_t, uint8_t);		/* Set I2C low address and type of operation */
-void I2C_Start(void);				/* Generate start condition */
+#define I2C_SPEED_STD		0		/* standard mode, 100 kHz */
+#define I2C_SPEED_FAST		1		/* fast mode, 400 kHz */
+
+#define I2C_ERR_NONE		0
+#define I2C_ERR_TIMEOUT		1		/* SCL held low by a slave too long */
+#define I2C_ERR_BUS		2		/* SDA held low by somebody else */
+
+void I2C_Speed(uint8_t);			/* Select bus speed for the next transaction */
+void I2C_Start(void);				/* Generate start condition (repeated START inside a transaction) */
 void I2C_Stop(void);				/* Generate stop condition */
 void I2C_Write_B (uint8_t);			/* Write one byte to temporary register */
+uint8_t I2C_Write_B_Ack(uint8_t);		/* Write one byte and test ACK of the slave */
 uint8_t I2C_Read_B (uint8_t);			/* Read one byte from I2C */
 uint8_t I2C_Ack_In(void);			/* Generate ACK pulse for slave present testing */
 void I2C_NoAck_Out(void);			/* Generate NON ACK for slave to stop next reading */
 void I2C_Ack_Out(void);				/* Generate ACK for slave for next reading */ 
-void I2C_Write_Block_W(uint16_t *);		/* Write block of word to I2C */
+uint8_t I2C_Write_Block_W(uint8_t, const uint16_t *);	/* Write block of words (MSB first) and STOP, 0 = NoACK */
 void I2C_Read_Block(uint8_t , uint8_t *);	/* Read block from I2C */
+uint8_t I2C_Write_Block(uint8_t, const uint8_t *);	/* Write block to I2C and STOP, 0 = NoACK */
 void I2C_Wait(void);                            /* Wait for I2C */
+void I2C_Init(void);				/* Configure RD0/RD1 as I2C master, free the bus */
+uint8_t I2C_Error(void);			/* Error of the last transaction, I2C_ERR_xxx */
+#if I2C_USE_MSSP
+void I2C_Reset(void);				/* Abort the MSSP, free the bus, start again idle */
+#endif
 #endif
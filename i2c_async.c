@@ -0,0 +1,323 @@
+/*
+ * File:   i2c_async.c
+ *
+ * Non-blocking I2C transaction engine. Transactions are kept in a small
+ * queue of descriptors; the MSSP2 interrupt advances the one on the bus
+ * through the states below, one bus event per interrupt:
+ *
+ *   START -> address W -> register -> data ... -> STOP              (write)
+ *   START -> address W -> register -> RESTART -> address R
+ *         -> data + ACK ... -> data + NoACK -> STOP                  (read)
+ *
+ * The register address takes reg_width bytes of the device (MSB first),
+ * a read of a device without registers starts with the address R.
+ *
+ * The main loop only polls the status of its descriptor (or gets the done
+ * callback) and is free to render and scan buttons while the bus works.
+ *
+ * A bus collision (BCL2IF) resets the MSSP and fails the transaction. A
+ * slave holding SCL low raises no interrupt at all, so every transaction
+ * gets a deadline in scheduler ticks, I2C_MSSP_TIMEOUT_US per bus event;
+ * i2c_async_check() (from i2c_async_wait() and the RTC task) aborts it
+ * when it has passed, frees the bus and starts the next one.
+ *
+ * With the bit-banged backend there is no interrupt source, so the
+ * transactions are executed synchronously inside i2c_async_submit() by
+ * i2c_dev.c.
+ */
+
+#include "hal.h"
+
+#include "avr/io.h"
+#include "i2c2.h"
+#include "i2c_dev.h"
+#include "i2c_async.h"
+#include "sched.h"
+
+#if I2C_ASYNC
+
+#define ST_IDLE			0		/* no transaction on the bus */
+#define ST_START		1		/* START sent */
+#define ST_ADDR_W		2		/* chip address (write) sent */
+#define ST_REG			3		/* register pointer sent */
+#define ST_WDATA		4		/* data byte sent */
+#define ST_RESTART		5		/* repeated START sent */
+#define ST_ADDR_R		6		/* chip address (read) sent */
+#define ST_RDATA		7		/* data byte received */
+#define ST_RACK			8		/* ACK/NoACK after data sent */
+#define ST_STOP			9		/* STOP sent */
+
+#if I2C_USE_MSSP
+
+/* bus events of a transaction at most: START, address, 2 register bytes,
+ * RESTART, address, 2 per data byte, STOP */
+#define I2C_EVENTS(x)		(7 + 2 * (uint16_t)(x)->len)
+#define I2C_DEADLINE(x)		(tick_t)((uint32_t)I2C_EVENTS(x) * I2C_MSSP_TIMEOUT_US / 1000 + 2)
+
+static i2c_xfer_t *queue[I2C_ASYNC_QUEUE];
+static volatile uint8_t q_head = 0;		/* next transaction to run */
+static volatile uint8_t q_count = 0;		/* transactions in queue incl. running */
+static volatile uint8_t state = ST_IDLE;
+static uint8_t pos;				/* index of next data byte */
+static uint8_t regs;				/* register address bytes left */
+static uint16_t bytes;				/* bytes on the bus so far */
+static uint8_t result;				/* final status of current transaction */
+static tick_t deadline;				/* of the current transaction */
+
+/*!
+ * \brief Start the transaction at the head of the queue (interrupts off)
+ */
+static void i2c_async_next(void)
+{
+	if (!q_count) {
+		state = ST_IDLE;
+		PIE3bits.SSP2IE = 0;		/* nothing to do, no interrupts */
+		PIE3bits.BCL2IE = 0;
+		return;
+	}
+	queue[q_head]->status = I2C_XFER_BUSY;
+	I2C_Speed(queue[q_head]->dev->speed);
+	pos = 0;
+	regs = queue[q_head]->dev->reg_width;
+	bytes = 0;
+	result = I2C_XFER_DONE;
+	state = ST_START;
+	deadline = sched_ticks() + I2C_DEADLINE(queue[q_head]);
+	PIR3bits.SSP2IF = 0;
+	PIR3bits.BCL2IF = 0;
+	PIE3bits.SSP2IE = 1;
+	PIE3bits.BCL2IE = 1;
+	SSP2CON2bits.SEN = 1;
+}
+
+/*!
+ * \brief Function completes the transaction at the head of the queue and
+ * starts the next one
+ *
+ * \param status	Final status of the transaction
+ */
+static void i2c_async_finish(uint8_t status)
+{
+	i2c_xfer_t *x = queue[q_head];
+
+	x->status = status;
+	i2c_dev_count(x->dev, bytes, status == I2C_XFER_DONE);
+	q_head = (q_head + 1) % I2C_ASYNC_QUEUE;
+	q_count--;
+	if (x->done)
+		x->done(x);
+	i2c_async_next();
+}
+
+/*!
+ * \brief Function gives up the transaction on the bus: the MSSP is reset,
+ * the bus freed and the transaction fails
+ */
+static void i2c_async_abort(void)
+{
+	I2C_Reset();
+	i2c_async_finish(I2C_XFER_ERROR);
+}
+
+/*!
+ * \brief Finish current transaction by STOP condition
+ *
+ * \param status	Final status of the transaction
+ */
+static void i2c_async_stop(uint8_t status)
+{
+	result = status;
+	state = ST_STOP;
+	SSP2CON2bits.PEN = 1;
+}
+
+/*!
+ * \brief MSSP2 interrupt handler, one bus event per call
+ */
+void i2c_async_isr(void)
+{
+	i2c_xfer_t *x;
+
+	if (PIE3bits.BCL2IE && PIR3bits.BCL2IF) {	/* collision, MSSP went idle */
+		PIR3bits.BCL2IF = 0;
+		i2c_async_abort();
+		return;
+	}
+	if (!PIE3bits.SSP2IE || !PIR3bits.SSP2IF)
+		return;
+	PIR3bits.SSP2IF = 0;
+	x = queue[q_head];
+
+	switch (state) {
+	case ST_START:
+		bytes++;
+		if (!regs && x->dir == I2C_XFER_READ) {
+			state = ST_ADDR_R;
+			SSP2BUF = (x->dev->addr << 1) | 0x01;
+		} else {
+			state = ST_ADDR_W;
+			SSP2BUF = x->dev->addr << 1;
+		}
+		break;
+	case ST_ADDR_W:				/* NoACK: nobody answers */
+	case ST_REG:
+	case ST_WDATA:
+		if (SSP2CON2bits.ACKSTAT) {
+			i2c_async_stop(I2C_XFER_ERROR);
+		} else if (regs) {
+			state = ST_REG;
+			bytes++;
+			SSP2BUF = (regs-- == 2) ? x->reg >> 8 : x->reg;
+		} else if (x->dir == I2C_XFER_READ) {
+			state = ST_RESTART;
+			SSP2CON2bits.RSEN = 1;
+		} else if (pos < x->len) {
+			state = ST_WDATA;
+			bytes++;
+			SSP2BUF = x->buf[pos++];
+		} else {
+			i2c_async_stop(I2C_XFER_DONE);
+		}
+		break;
+	case ST_RESTART:
+		state = ST_ADDR_R;
+		bytes++;
+		SSP2BUF = (x->dev->addr << 1) | 0x01;
+		break;
+	case ST_ADDR_R:
+		if (SSP2CON2bits.ACKSTAT) {
+			i2c_async_stop(I2C_XFER_ERROR);
+			break;
+		}
+		/* fall through */
+	case ST_RACK:
+		if (pos < x->len) {
+			state = ST_RDATA;
+			SSP2CON2bits.RCEN = 1;
+		} else {
+			i2c_async_stop(I2C_XFER_DONE);
+		}
+		break;
+	case ST_RDATA:
+		x->buf[pos++] = SSP2BUF;
+		bytes++;
+		state = ST_RACK;
+		SSP2CON2bits.ACKDT = (pos < x->len) ? 0 : 1;	/* NoACK after last byte */
+		SSP2CON2bits.ACKEN = 1;
+		break;
+	case ST_STOP:
+		i2c_async_finish(result);
+		break;
+	default:
+		break;
+	}
+}
+
+#else /* !I2C_USE_MSSP */
+
+void i2c_async_isr(void)
+{
+}
+
+/*!
+ * \brief Run one transaction on the bit-banged bus (blocking)
+ */
+static void i2c_async_run(i2c_xfer_t *x)
+{
+	uint8_t ok;
+
+	x->status = I2C_XFER_BUSY;
+	if (x->dir == I2C_XFER_READ)
+		ok = i2c_dev_read(x->dev, x->reg, x->buf, x->len);
+	else
+		ok = i2c_dev_write(x->dev, x->reg, x->buf, x->len);
+	x->status = ok ? I2C_XFER_DONE : I2C_XFER_ERROR;
+	if (x->done)
+		x->done(x);
+}
+
+#endif /* I2C_USE_MSSP */
+
+/*!
+ * \brief Function queues a transaction and returns immediately
+ *
+ * \param	*x	Transaction descriptor, must stay valid until it finishes
+ * \return	1	Queued
+ * \return	0	Queue is full, status set to I2C_XFER_ERROR
+ */
+uint8_t i2c_async_submit(i2c_xfer_t *x)
+{
+#if I2C_USE_MSSP
+	uint8_t ie;
+
+	if (!SSP2CON1bits.SSPEN)
+		I2C_Init();
+
+	ie = INTCONbits.GIEH;
+	INTCONbits.GIEH = 0;
+	if (q_count == I2C_ASYNC_QUEUE) {
+		INTCONbits.GIEH = ie;
+		x->status = I2C_XFER_ERROR;
+		return (0);
+	}
+	x->status = I2C_XFER_QUEUED;
+	queue[(q_head + q_count) % I2C_ASYNC_QUEUE] = x;
+	q_count++;
+	if (state == ST_IDLE)
+		i2c_async_next();
+	INTCONbits.GIEH = ie;
+#else
+	i2c_async_run(x);
+#endif
+	return (1);
+}
+
+/*!
+ * \brief Function tests whether the engine has any work
+ */
+uint8_t i2c_async_busy(void)
+{
+#if I2C_USE_MSSP
+	return (q_count != 0);
+#else
+	return (0);
+#endif
+}
+
+/*!
+ * \brief Function aborts the transaction on the bus when it is past its
+ * deadline (a slave holds SCL low, no interrupt comes), the next one starts
+ *
+ * \return	1 .. a transaction was aborted
+ */
+uint8_t i2c_async_check(void)
+{
+#if I2C_USE_MSSP
+	uint8_t ie, hit = 0;
+
+	ie = INTCONbits.GIEH;
+	INTCONbits.GIEH = 0;
+	if (state != ST_IDLE && sched_reached(deadline)) {
+		i2c_async_abort();
+		hit = 1;
+	}
+	INTCONbits.GIEH = ie;
+	return (hit);
+#else
+	return (0);
+#endif
+}
+
+/*!
+ * \brief Function waits until the transaction leaves the queue, at most
+ * until its deadline
+ */
+void i2c_async_wait(i2c_xfer_t *x)
+{
+	while (x->status == I2C_XFER_QUEUED || x->status == I2C_XFER_BUSY) {
+		(void)i2c_async_check();
+		hal_poll();
+	}
+}
+
+#endif /* I2C_ASYNC */
@@ -0,0 +1,45 @@
+/*
+ * File:   i2c_async.h
+ *
+ * Interrupt driven, non-blocking I2C transactions. A transaction is
+ * described by i2c_xfer_t, queued by i2c_async_submit() and advanced by
+ * i2c_async_isr() from the MSSP2 interrupt. Completion is signalled by the
+ * status field and optionally by the done callback (called from the ISR). The transactions are counted in the
+ * statistics of their device like the blocking ones of i2c_dev.c. A
+ * transaction hit by a bus collision or past its deadline fails and the
+ * queue goes on with the next one (i2c_async_check()).
+ */
+
+#ifndef _I2C_ASYNC_H
+#define _I2C_ASYNC_H
+
+#include <stdint.h>
+#include "config.h"
+#include "i2c_dev.h"
+
+#define I2C_XFER_WRITE		0		/* write len bytes to reg */
+#define I2C_XFER_READ		1		/* read len bytes from reg */
+
+#define I2C_XFER_IDLE		0		/* never submitted */
+#define I2C_XFER_QUEUED		1		/* waiting in the queue */
+#define I2C_XFER_BUSY		2		/* on the bus */
+#define I2C_XFER_DONE		3		/* finished OK */
+#define I2C_XFER_ERROR		4		/* NoACK, bus collision, timeout or queue full */
+
+typedef struct i2c_xfer {
+	i2c_dev_t *dev;				/* device: address, speed, register width */
+	uint16_t reg;				/* register address sent first */
+	uint8_t dir;				/* I2C_XFER_WRITE / I2C_XFER_READ */
+	uint8_t len;				/* number of data bytes */
+	uint8_t *buf;				/* data to write / space for read data */
+	void (*done)(struct i2c_xfer *);	/* completion callback or 0 */
+	volatile uint8_t status;		/* I2C_XFER_xxx */
+} i2c_xfer_t;
+
+uint8_t i2c_async_submit(i2c_xfer_t *);		/* Queue transaction, 0 if the queue is full */
+uint8_t i2c_async_busy(void);			/* Is any transaction queued or running ? */
+void i2c_async_wait(i2c_xfer_t *);		/* Block until the transaction finishes */
+uint8_t i2c_async_check(void);			/* Abort a transaction past its deadline, 1 = aborted */
+void i2c_async_isr(void);			/* MSSP2 interrupt handler */
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ * File:   i2c_dev.c
+ *
+ * Blocking transactions with the devices of the I2C bus on top of the
+ * I2C_xxx primitives of the selected backend (i2c2.c / i2c_mssp.c).
+ * The register address is sent MSB first in reg_width bytes, a device
+ * without registers (width 0) is read right after its address. Every
+ * byte is checked for ACK, a NoACK ends the transaction by STOP. A read
+ * also fails on a bus error of the backend (I2C_Error()).
+ *
+ * Writes stream the buffer through I2C_Write_Block() / I2C_Write_Block_W(),
+ * one transaction per page of a memory device (one per 255 bytes
+ * otherwise). After a page the device is marked busy and the next
+ * transaction polls its address first, every 100 us for at most
+ * I2C_WRITE_CYCLE_MS; the polls are counted as one transaction.
+ */
+
+#include "hal.h"
+
+#include "i2c_dev.h"
+
+/*!
+ * \brief Function counts one transaction of the device
+ *
+ * \param *d	Device
+ * \param n	Bytes on the bus incl. addresses
+ * \param ok	Transaction was acknowledged
+ */
+void i2c_dev_count(i2c_dev_t *d, uint16_t n, uint8_t ok)
+{
+	d->stat.xfers++;
+	d->stat.bytes += n;
+	if (!ok)
+		d->stat.errors++;
+}
+
+/*!
+ * \brief Function starts a write transaction: START, address W, register
+ *
+ * \param *d	Device
+ * \param reg	Register address
+ * \param *n	Byte counter
+ * \return	0 .. NoACK, 1 .. OK
+ */
+static uint8_t i2c_dev_start(i2c_dev_t *d, uint16_t reg, uint16_t *n)
+{
+	uint8_t i;
+
+	I2C_Speed(d->speed);
+	I2C_Start();
+	(*n)++;
+	if (!I2C_Write_B_Ack(d->addr << 1))
+		return (0);
+	for (i = d->reg_width; i; i--) {
+		(*n)++;
+		if (!I2C_Write_B_Ack((i == 2) ? reg >> 8 : reg))
+			return (0);
+	}
+	return (1);
+}
+
+/*!
+ * \brief Function reads len bytes from the registers of the device
+ *
+ * \param *d	Device
+ * \param reg	First register
+ * \param *buf	Memory for the data
+ * \param len	Number of bytes
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t i2c_dev_read(i2c_dev_t *d, uint16_t reg, uint8_t *buf, uint8_t len)
+{
+	uint16_t n = 0;
+	uint8_t ok = 1;
+
+	if (!i2c_dev_ready(d))
+		return (0);
+	if (d->reg_width) {
+		ok = i2c_dev_start(d, reg, &n);
+	} else {
+		I2C_Speed(d->speed);
+	}
+	if (ok) {
+		I2C_Start();			/* repeated START after the register */
+		n++;
+		ok = I2C_Write_B_Ack((d->addr << 1) | 0x01);
+	}
+	if (ok && len) {
+		I2C_Read_Block(len, buf);	/* generates STOP */
+		n += len;
+		ok = (I2C_Error() == I2C_ERR_NONE);
+	} else {
+		I2C_Stop();
+	}
+	i2c_dev_count(d, n, ok);
+	return (ok);
+}
+
+/*!
+ * \brief Function waits until a memory device finished its write cycle,
+ * its address is sent until it is acknowledged (ACK polling)
+ *
+ * \param *d	Device
+ * \return	0 .. no ACK within I2C_WRITE_CYCLE_MS, 1 .. ready
+ */
+uint8_t i2c_dev_ready(i2c_dev_t *d)
+{
+	uint16_t polls = 0;
+	uint8_t ok;
+
+	if (!d->busy)
+		return (1);
+	d->busy = 0;
+	I2C_Speed(d->speed);
+	do {
+		if (polls)
+			hal_delay_us(100);
+		I2C_Start();
+		ok = I2C_Write_B_Ack(d->addr << 1);
+		I2C_Stop();
+	} while (!ok && ++polls <= I2C_WRITE_CYCLE_MS * 10);
+	i2c_dev_count(d, polls + ok, ok);
+	return (ok);
+}
+
+/*!
+ * \brief Function streams len bytes to the device from register reg on,
+ * one transaction per page. Words go MSB first and never cross a page.
+ *
+ * \param *d	Device
+ * \param reg	First register
+ * \param *buf	Data, uint16_t for words
+ * \param len	Number of bytes, even for words
+ * \param words	0 .. bytes, 1 .. words (reg must be even on a paged device)
+ * \return	0 .. NoACK or device not ready, 1 .. OK
+ */
+static uint8_t i2c_dev_stream(i2c_dev_t *d, uint16_t reg, const uint8_t *buf, uint16_t len, uint8_t words)
+{
+	uint16_t chunk, n;
+	uint8_t ok = 1;
+
+	while (ok && len) {
+		chunk = d->page ? d->page - reg % d->page : 255;
+		if (chunk > len)
+			chunk = len;
+		if (words)
+			chunk &= ~1;
+		if (!chunk || !i2c_dev_ready(d))
+			return (0);
+		n = 0;
+		if (i2c_dev_start(d, reg, &n)) {
+			if (words)
+				ok = I2C_Write_Block_W(chunk / 2, (const uint16_t *)buf);
+			else
+				ok = I2C_Write_Block(chunk, buf);	/* generates STOP */
+			n += chunk;
+		} else {
+			ok = 0;
+			I2C_Stop();
+		}
+		i2c_dev_count(d, n, ok);
+		d->busy = (d->page != 0);		/* write cycle started */
+		buf += chunk;
+		reg += chunk;
+		len -= chunk;
+	}
+	return (ok);
+}
+
+/*!
+ * \brief Function writes len bytes to the registers of the device
+ *
+ * \param *d	Device
+ * \param reg	First register
+ * \param *buf	Data
+ * \param len	Number of bytes
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t i2c_dev_write(i2c_dev_t *d, uint16_t reg, const uint8_t *buf, uint8_t len)
+{
+	return (i2c_dev_stream(d, reg, buf, len, 0));
+}
+
+/*!
+ * \brief Function writes a buffer of any length, split at the pages of a
+ * memory device. Returns without waiting for the last write cycle.
+ *
+ * \param *d	Device
+ * \param addr	First byte address
+ * \param *buf	Data
+ * \param len	Number of bytes
+ * \return	0 .. NoACK or device not ready, 1 .. OK
+ */
+uint8_t i2c_dev_write_block(i2c_dev_t *d, uint16_t addr, const uint8_t *buf, uint16_t len)
+{
+	return (i2c_dev_stream(d, addr, buf, len, 0));
+}
+
+/*!
+ * \brief Function writes words MSB first like i2c_dev_write_block()
+ *
+ * \param *d	Device
+ * \param addr	First byte address, even on a paged device
+ * \param *buf	Data
+ * \param n	Number of words
+ * \return	0 .. NoACK or device not ready, 1 .. OK
+ */
+uint8_t i2c_dev_write_block_w(i2c_dev_t *d, uint16_t addr, const uint16_t *buf, uint16_t n)
+{
+	return (i2c_dev_stream(d, addr, (const uint8_t *)buf, n * 2, 1));
+}
+
+/*!
+ * \brief Function tests whether the device acknowledges its address
+ *
+ * \param *d	Device
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t i2c_dev_probe(i2c_dev_t *d)
+{
+	uint8_t ok;
+
+	I2C_Speed(d->speed);
+	I2C_Start();
+	ok = I2C_Write_B_Ack(d->addr << 1);
+	I2C_Stop();
+	i2c_dev_count(d, 1, ok);
+	return (ok);
+}
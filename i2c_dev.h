@@ -0,0 +1,50 @@
+/*
+ * File:   i2c_dev.h
+ *
+ * Devices on the I2C bus (RD0/RD1). Every chip is described by an
+ * i2c_dev_t: 7 bit address, bus speed and width of its register address.
+ * A read is one transaction: START, address W, register, repeated START,
+ * address R, data, STOP. The transactions of every device are counted.
+ *
+ * Memory devices (24Cxx) also have a page: a write must not cross a page
+ * boundary and is followed by a write cycle in which the chip does not
+ * acknowledge its address. Writes are split at the page boundaries and
+ * the next transaction with the device first polls its address until it
+ * answers (ACK polling), so a write cycle costs only the time it really
+ * takes and the caller does not wait for the last one.
+ */
+
+#ifndef _I2C_DEV_H
+#define _I2C_DEV_H
+
+#include <stdint.h>
+#include "config.h"
+#include "i2c2.h"
+
+typedef struct {
+	uint16_t xfers;			/* transactions */
+	uint16_t errors;		/* of them not acknowledged / bus error */
+	uint32_t bytes;			/* bytes on the bus incl. addresses */
+} i2c_stat_t;
+
+typedef struct {
+	uint8_t addr;			/* 7 bit address, e.g. 0x50 */
+	uint8_t speed;			/* I2C_SPEED_STD / I2C_SPEED_FAST */
+	uint8_t reg_width;		/* register address bytes, 0 .. 2 */
+	uint8_t page;			/* page of a memory device in bytes, 0 = none */
+	uint8_t busy;			/* write cycle may be running */
+	i2c_stat_t stat;
+} i2c_dev_t;
+
+#define I2C_DEV(addr, speed, width)	{ (addr), (speed), (width), 0, 0, { 0, 0, 0 } }
+#define I2C_DEV_MEM(addr, speed, width, page)	{ (addr), (speed), (width), (page), 0, { 0, 0, 0 } }
+
+uint8_t i2c_dev_read(i2c_dev_t *, uint16_t, uint8_t *, uint8_t);	/* Read registers, 0 = NoACK */
+uint8_t i2c_dev_write(i2c_dev_t *, uint16_t, const uint8_t *, uint8_t);	/* Write registers, 0 = NoACK */
+uint8_t i2c_dev_write_block(i2c_dev_t *, uint16_t, const uint8_t *, uint16_t);	/* Write bytes, split at pages */
+uint8_t i2c_dev_write_block_w(i2c_dev_t *, uint16_t, const uint16_t *, uint16_t);	/* Write words, MSB first */
+uint8_t i2c_dev_ready(i2c_dev_t *);	/* Wait for the end of a write cycle, 0 = timeout */
+uint8_t i2c_dev_probe(i2c_dev_t *);	/* Does the device acknowledge its address ? */
+void i2c_dev_count(i2c_dev_t *, uint16_t, uint8_t);	/* Count a transaction (bytes, ok) */
+
+#endif
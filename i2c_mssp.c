@@ -0,0 +1,277 @@
+/*
+ * File:   i2c_mssp.c
+ *
+ * Hardware I2C backend built on the MSSP2 peripheral of PIC18F46K22.
+ * SCL2/SDA2 share the RD0/RD1 pins with the bit-banged driver in i2c2.c,
+ * so the backend is selected by I2C_USE_MSSP in config.h without any change
+ * of wiring or of the I2C_xxx API used by yunimain.c.
+ *
+ * getTime() runs one transaction of 8 bytes on the bus (address and
+ * register pointer, address for reading, 5 data bytes) with a repeated
+ * START. Its length is set by SCL, not by the backend, so the MSSP does
+ * not make it shorter; the gain is the CPU time it leaves free
+ * (Fosc = 16 MHz, Tcy = 250 ns, counted from the code, not measured):
+ *
+ *                          bit-banged     MSSP, blocking   MSSP, I2C_ASYNC
+ *   SCL frequency          ~95 kHz        100 kHz          100 kHz
+ *   one byte + ACK         ~390 Tcy       360 Tcy          360 Tcy
+ *   on the bus             ~0.8 ms        ~0.74 ms         ~0.74 ms
+ *   CPU busy               ~3200 Tcy      ~3000 Tcy        ~850 Tcy
+ *   CPU free meanwhile     0 %            0 %              ~70 %
+ *
+ * The bit-banged driver toggles the pins itself and the blocking MSSP
+ * calls spin on SSP2IF, so either takes the CPU for the whole transfer.
+ * The interrupt engine (i2c_async.c) costs ~50 Tcy for each of the 16
+ * bus events (START, 2 addresses, register, RESTART, 5 x receive + ACK,
+ * STOP) plus the submit; the rest of the 0.74 ms goes to rendering,
+ * buttons or IDLE.
+ *
+ * The wait gives up after I2C_MSSP_TIMEOUT_US (a slave stretching SCL too
+ * long) or on a bus collision (BCL2IF), then the rest of the transaction
+ * is a no-op like in i2c2.c and I2C_Stop() resets the MSSP.
+ */
+
+#include "hal.h"
+
+#include "avr/io.h"
+#include "i2c2.h"
+
+#if I2C_USE_MSSP
+
+#define I2C_ADD(f)		(uint8_t)(_XTAL_FREQ / (4 * (f)) - 1)	/* baud rate generator */
+#define I2C_FAST		400000UL
+
+#define I2C_BUS_IDLE		0		/* no transfer in progress */
+#define I2C_BUS_START		1		/* START sent, no byte transferred yet */
+#define I2C_BUS_DATA		2		/* master owns the bus and transferred data */
+
+#define I2C_MHZ		(_XTAL_FREQ / 4000000UL)	/* Tcy per us */
+#define I2C_POLL_OVH	8	/* Tcy of one SSP2IF poll besides its 1 us delay */
+#define I2C_POLLS	(uint16_t)(I2C_MSSP_TIMEOUT_US * I2C_MHZ / (I2C_MHZ + I2C_POLL_OVH))
+
+static uint8_t i2c_bus = I2C_BUS_IDLE;
+static uint8_t i2c_err = I2C_ERR_NONE;		/* of the current transaction */
+
+/*!
+ * \brief Function configures MSSP2 as I2C master on RD0/RD1
+ */
+void I2C_Init(void)
+{
+	TRISDbits.TRISD0 = 1; TRISDbits.TRISD1 = 1;	/* MSSP drives the pins as open drain */
+
+	SSP2ADD = I2C_ADD(I2C_MSSP_SPEED);		/* baud rate generator */
+	SSP2STAT = 0x80;				/* slew rate control off (100 kHz) */
+	SSP2CON2 = 0;
+	SSP2CON1 = 0x28;				/* SSPEN, I2C master mode */
+	PIR3bits.SSP2IF = 0;
+	PIR3bits.BCL2IF = 0;
+	i2c_bus = I2C_BUS_IDLE;
+	i2c_err = I2C_ERR_NONE;
+}
+
+/*!
+ * \brief Function aborts whatever the MSSP does and frees the bus: with the
+ * MSSP off, a slave stuck in a byte gets up to 9 clocks until it releases
+ * SDA, then the MSSP starts again idle
+ */
+void I2C_Reset(void)
+{
+	uint8_t cnt = 9;
+
+	SSP2CON1bits.SSPEN = 0;				/* RD0/RD1 are port pins again */
+	LATDbits.LATD0 = 0;
+	TRISDbits.TRISD1 = 1;
+	while (!PORTDbits.RD1 && cnt--) {
+		TRISDbits.TRISD0 = 0;			/* SCL low */
+		hal_delay_us(5);
+		TRISDbits.TRISD0 = 1;			/* released to the pull-up */
+		hal_delay_us(5);
+	}
+	I2C_Init();
+}
+
+/*!
+ * \brief Function selects the bus speed of the next transaction
+ *
+ * \param speed	I2C_SPEED_STD (I2C_MSSP_SPEED) / I2C_SPEED_FAST (400 kHz)
+ */
+void I2C_Speed(uint8_t speed)
+{
+	if (!SSP2CON1bits.SSPEN)
+		I2C_Init();
+	if (speed == I2C_SPEED_FAST) {
+		SSP2ADD = I2C_ADD(I2C_FAST);
+		SSP2STATbits.SMP = 0;			/* slew rate control for 400 kHz */
+	} else {
+		SSP2ADD = I2C_ADD(I2C_MSSP_SPEED);
+		SSP2STATbits.SMP = 1;
+	}
+}
+
+/*!
+ * \brief Function returns the error of the last transaction
+ *
+ * \return	I2C_ERR_NONE, I2C_ERR_TIMEOUT, I2C_ERR_BUS
+ */
+uint8_t I2C_Error(void)
+{
+	return (i2c_err);
+}
+
+/*!
+ * \brief Wait until MSSP finishes the current bus event, at most
+ * I2C_MSSP_TIMEOUT_US
+ */
+void I2C_Wait(void)
+{
+	uint16_t n = I2C_POLLS;
+
+	while (!PIR3bits.SSP2IF && !PIR3bits.BCL2IF) {
+		if (!--n) {
+			i2c_err = I2C_ERR_TIMEOUT;
+			return;
+		}
+		hal_delay_us(1);
+	}
+	if (PIR3bits.BCL2IF) {			/* MSSP went idle, the bus is lost */
+		PIR3bits.BCL2IF = 0;
+		i2c_err = I2C_ERR_BUS;
+	}
+	PIR3bits.SSP2IF = 0;
+}
+
+/*!
+ * \brief Function generates START (or repeated START) condition on I2C,
+ * a START on an idle bus begins a new transaction and clears the error
+ *
+ */
+void I2C_Start(void)
+{
+	if (!SSP2CON1bits.SSPEN)
+		I2C_Init();
+
+	if (i2c_bus == I2C_BUS_IDLE)
+		i2c_err = I2C_ERR_NONE;
+	if (i2c_err || i2c_bus == I2C_BUS_START)	/* START already on the bus */
+		return;
+	if (i2c_bus == I2C_BUS_DATA)
+		SSP2CON2bits.RSEN = 1;			/* bus is ours, repeated START */
+	else
+		SSP2CON2bits.SEN = 1;
+	I2C_Wait();
+	i2c_bus = I2C_BUS_START;
+}
+
+/*!
+ * \brief Function generates STOP condition on I2C, after an error it
+ * resets the MSSP instead (the error stays for I2C_Error())
+ *
+ */
+void I2C_Stop(void)
+{
+	uint8_t err;
+
+	if (i2c_bus == I2C_BUS_IDLE)		/* nothing to finish */
+		return;
+	if (!i2c_err) {
+		SSP2CON2bits.PEN = 1;
+		I2C_Wait();
+	}
+	i2c_bus = I2C_BUS_IDLE;
+	if (i2c_err) {
+		err = i2c_err;
+		I2C_Reset();				/* abort the pending event */
+		i2c_err = err;
+	}
+}
+
+/*!
+ * \brief Function writes one byte to I2C, ACK is clocked in by MSSP
+ *
+ * \param dta	Data for writing
+ */
+void I2C_Write_B(uint8_t dta)
+{
+	if (i2c_err)
+		return;
+	SSP2BUF = dta;
+	I2C_Wait();
+	i2c_bus = I2C_BUS_DATA;
+}
+
+/*!
+ * \brief Function writes one byte to I2C and tests the ACK of the slave
+ *
+ * \param dta	Data for writing
+ * \return 0	Err, NoACK from I2C device or bus error
+ * \return 1	OK,  ACK from I2C device
+ */
+uint8_t I2C_Write_B_Ack(uint8_t dta)
+{
+	I2C_Write_B(dta);
+	return (I2C_Ack_In());
+}
+
+/*!
+ * \brief Function reads one byte from I2C and generates an ACK condition
+ *
+ * \param 	ack	Type of ACK, 0 .. NoACK, 1 .. Ack
+ * \return	dta	Read value, 0xff after a bus error
+ */
+uint8_t I2C_Read_B(uint8_t ack)
+{
+	uint8_t dta;
+
+	if (i2c_err)
+		return (0xff);
+	SSP2CON2bits.RCEN = 1;				/* receive one byte */
+	I2C_Wait();
+	if (i2c_err)
+		return (0xff);
+	dta = SSP2BUF;
+	i2c_bus = I2C_BUS_DATA;
+	if (ack)
+		I2C_Ack_Out();
+	else
+		I2C_NoAck_Out();
+	return (dta);
+}
+
+/*!
+ * \brief Function returns ACK received for the last written byte
+ *
+ * \return 0	Err, NoACK from I2C device or bus error
+ * \return 1	OK,  ACK from I2C device
+ */
+uint8_t I2C_Ack_In(void)
+{
+	if (i2c_err)
+		return (0);
+	return (SSP2CON2bits.ACKSTAT ? 0 : 1);
+}
+
+/*!
+ * \brief Function I2C_NoAck_Out generates NoACK pulse
+ */
+void I2C_NoAck_Out(void)
+{
+	if (i2c_err)
+		return;
+	SSP2CON2bits.ACKDT = 1;
+	SSP2CON2bits.ACKEN = 1;
+	I2C_Wait();
+}
+
+/*!
+ * \brief Function I2C_Ack_Out generates ACK pulse
+ */
+void I2C_Ack_Out(void)
+{
+	if (i2c_err)
+		return;
+	SSP2CON2bits.ACKDT = 0;
+	SSP2CON2bits.ACKEN = 1;
+	I2C_Wait();
+}
+
+#endif /* I2C_USE_MSSP */
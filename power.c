@@ -0,0 +1,161 @@
+/*
+ * File:   power.c
+ *
+ * Power management. The scheduler calls power_idle() when no task is
+ * ready. The CPU then waits in IDLE mode (peripherals and the 1 ms tick
+ * keep running) or, with LOW_POWER, in SLEEP mode when no timed task is
+ * pending and no peripheral is busy; SLEEP is left on the RTC 1 Hz edge
+ * (RB5) or the SOSC Timer1 second, or on a button edge (INT0..INT2).
+ * The system tick stops during SLEEP, which is harmless because no task
+ * waits for a time then.
+ *
+ * Duty-cycle counter: every 1 ms tick which wakes the CPU from IDLE is
+ * idle time, every other tick is active time. The wall time is counted in
+ * seconds of the clock, so time in SLEEP (no ticks) counts as idle too:
+ *
+ *	duty = active ms / (seconds * 1000)
+ */
+
+#include "hal.h"
+
+#include "power.h"
+#include "display.h"
+#include "buttons.h"
+#include "i2c_async.h"
+
+#if LOW_POWER && !RTC_EVENT_DRIVEN && !(LOCAL_TIME && LOCAL_TIME_SOSC)
+#error "LOW_POWER needs a 1 Hz wake-up: RTC_EVENT_DRIVEN or LOCAL_TIME_SOSC"
+#endif
+
+static uint32_t power_awake_ms = 0;	/* ticks counted */
+static uint32_t power_idle_ms = 0;	/* ticks which found the CPU waiting */
+static uint32_t power_seconds = 0;	/* wall time */
+static uint16_t power_inactive = 0;	/* seconds without user activity */
+static uint8_t power_lcd = 1;		/* LCD switched on */
+
+/*!
+ * \brief Function disables the clock of peripherals this build does not use
+ */
+void power_init(void)
+{
+	PMD0bits.UART1MD = 1;
+#if !(PROFILE && PROFILE_UART)
+	PMD0bits.UART2MD = 1;
+#endif
+#if !PROFILE
+	PMD0bits.TMR3MD = 1;
+#endif
+	PMD0bits.TMR5MD = 1;
+	PMD0bits.TMR6MD = 1;
+#if !BENCH_LCD && !BENCH_EEPROM && !LOCAL_TIME
+	PMD0bits.TMR1MD = 1;
+#endif
+#if !LCD_QUEUED
+	PMD0bits.TMR2MD = 1;
+#endif
+	PMD1bits.MSSP1MD = 1;
+#if !I2C_USE_MSSP
+	PMD1bits.MSSP2MD = 1;
+#endif
+	PMD1bits.CCP1MD = 1;
+	PMD1bits.CCP2MD = 1;
+	PMD1bits.CCP3MD = 1;
+	PMD1bits.CCP4MD = 1;
+	PMD1bits.CCP5MD = 1;
+	PMD2bits.ADCMD = 1;
+	PMD2bits.CMP1MD = 1;
+	PMD2bits.CMP2MD = 1;
+	PMD2bits.CTMUMD = 1;
+}
+
+/*!
+ * \brief Function waits for an interrupt
+ *
+ * Must be called with interrupts disabled (GIEH = 0), the pending interrupt
+ * wakes the CPU and is served once the caller enables interrupts again.
+ *
+ * \param timed	A task waits for its time, the tick must keep running
+ */
+void power_idle(uint8_t timed)
+{
+#if LOW_POWER
+	if (!timed && btn_idle() && !lcd_busy()
+#if I2C_ASYNC
+	    && !i2c_async_busy()
+#endif
+	    ) {
+		OSCCONbits.IDLEN = 0;		/* SLEEP: oscillator off */
+		hal_sleep();
+		return;
+	}
+#else
+	(void)timed;
+#endif
+	OSCCONbits.IDLEN = 1;			/* IDLE: peripherals run */
+	hal_sleep();
+	if (PIR5bits.TMR4IF)			/* woken by the tick */
+		power_idle_ms++;
+}
+
+/*!
+ * \brief System tick (interrupt context)
+ */
+void power_tick(void)
+{
+	power_awake_ms++;
+}
+
+/*!
+ * \brief New second: wall time and inactivity timeout of the LCD
+ */
+void power_second(void)
+{
+	power_seconds++;
+#if LOW_POWER
+	if (power_lcd && ++power_inactive >= POWER_LCD_OFF_S) {
+		lcd_display(0);
+		power_lcd = 0;
+	}
+#endif
+}
+
+/*!
+ * \brief User did something, switch the LCD on
+ *
+ * \return 1	LCD was off (the key press only woke it up)
+ * \return 0	LCD was on
+ */
+uint8_t power_activity(void)
+{
+	power_inactive = 0;
+	if (power_lcd)
+		return (0);
+	lcd_display(1);
+	power_lcd = 1;
+	return (1);
+}
+
+/*!
+ * \brief Is the LCD switched on ?
+ */
+uint8_t power_lcd_on(void)
+{
+	return (power_lcd);
+}
+
+/*!
+ * \brief Active CPU time since start in per mille of the wall time
+ */
+uint16_t power_duty(void)
+{
+	uint32_t active;
+
+	if (!power_seconds)
+		return (0);
+	hal_irq_off();
+	active = power_awake_ms - power_idle_ms;
+	hal_irq_on();
+	if (active > power_seconds * 1000)
+		return (1000);
+	return ((uint16_t)(active / power_seconds));
+}
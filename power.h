@@ -0,0 +1,22 @@
+/*
+ * File:   power.h
+ *
+ * Power management: peripheral gating, IDLE/SLEEP between tasks, display
+ * switch-off after inactivity and the duty-cycle counter.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "config.h"
+
+void power_init(void);			/* Gate the unused peripherals (PMD) */
+void power_idle(uint8_t);		/* Wait for interrupt, interrupts must be off */
+void power_tick(void);			/* Called on every system tick */
+void power_second(void);		/* Called on every new second of the clock */
+uint8_t power_activity(void);		/* User activity, 1 if the LCD was off */
+uint8_t power_lcd_on(void);		/* Is the LCD switched on ? */
+uint16_t power_duty(void);		/* Active CPU time in per mille */
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * File:   prof.c
+ *
+ * Cycle profiler. Timer3 runs free from Fosc/4 with the PROFILE_PS
+ * prescaler (1:1 .. 1:8) and 16 bit reads; PROF_BEGIN stores the timer
+ * per probe, PROF_END adds the difference to the probe's count, total,
+ * min and max. A section must be shorter than 65536 ticks (4 ms at 1:1
+ * and 64 MHz, 131 ms at 1:8 and 16 MHz). Probes measure inclusive time,
+ * interrupt handlers running meanwhile are counted too.
+ *
+ * The cost of an empty BEGIN/END pair is measured at prof_init() and
+ * subtracted from every sample. With PROFILE_UART prof_dump() sends the
+ * table as text on EUSART2 (TX2 = RD6, 8N1, PROFILE_BAUD).
+ */
+
+#include "hal.h"
+
+#include "prof.h"
+
+#if PROFILE
+
+#define PROF_T3CON	(((PROFILE_PS) << 4) | 0b00000011)	// Fosc/4, 16 bit reads, on
+#define PROF_SPBRG	(_XTAL_FREQ / 4 / PROFILE_BAUD - 1)	// BRGH = 1, BRG16 = 1
+
+static prof_t prof_table[PROF_PROBES];
+static uint16_t prof_start[PROF_PROBES];
+static uint16_t prof_zero = 0;		/* cost of the probe itself */
+
+static const char *const prof_names[PROF_PROBES] = {
+	"time", "disp", "lcdw", "keys"
+};
+
+/*!
+ * \brief Timer3, TMR3H is latched by reading TMR3L
+ */
+static uint16_t prof_now(void)
+{
+	uint16_t t;
+
+	t = TMR3L;
+	t |= (uint16_t)TMR3H << 8;
+	return (t);
+}
+
+/*!
+ * \brief Function clears the table
+ */
+void prof_reset(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < PROF_PROBES; i++) {
+		prof_table[i].count = 0;
+		prof_table[i].min = 0xffff;
+		prof_table[i].max = 0;
+		prof_table[i].total = 0;
+	}
+}
+
+/*!
+ * \brief Function starts Timer3 and measures an empty probe
+ */
+void prof_init(void)
+{
+	T3CON = PROF_T3CON;
+	prof_begin(0);
+	prof_end(0);
+	prof_zero = prof_table[0].max;
+	prof_reset();
+#if PROFILE_UART
+	ANSELD &= 0x3F;
+	hal_tris_or(D, 0xC0);		// EUSART2 drives TX2 itself
+	SPBRGH2 = PROF_SPBRG >> 8;
+	SPBRG2 = PROF_SPBRG & 0xFF;
+	BAUDCON2 = 0b00001000;		// BRG16
+	TXSTA2 = 0b00100100;		// TXEN, BRGH
+	RCSTA2 = 0b10000000;		// SPEN
+#endif
+}
+
+/*!
+ * \brief Start of probe p
+ */
+void prof_begin(uint8_t p)
+{
+	prof_start[p] = prof_now();
+}
+
+/*!
+ * \brief End of probe p, the sample is added to the table
+ */
+void prof_end(uint8_t p)
+{
+	uint16_t d = prof_now() - prof_start[p];
+	prof_t *e = &prof_table[p];
+
+	if (e->count == 0xffff)		/* full, keep the average right */
+		return;
+	d = d > prof_zero ? d - prof_zero : 0;
+	e->count++;
+	e->total += d;
+	if (d < e->min)
+		e->min = d;
+	if (d > e->max)
+		e->max = d;
+}
+
+/*!
+ * \brief Function copies probe p
+ *
+ * \return 0	Probe never ran
+ */
+uint8_t prof_get(uint8_t p, prof_t *e)
+{
+	*e = prof_table[p];
+	return (e->count != 0);
+}
+
+/*!
+ * \brief Name of probe p
+ */
+const char *prof_name(uint8_t p)
+{
+	return (prof_names[p]);
+}
+
+/*!
+ * \brief Timer3 ticks to us, saturates at 65535
+ */
+uint16_t prof_us(uint32_t t)
+{
+	t = t * (4UL << (PROFILE_PS)) / (_XTAL_FREQ / 1000000UL);
+	return (t > 0xffff ? 0xffff : (uint16_t)t);
+}
+
+#if PROFILE_UART
+static void prof_puts(const char *s)
+{
+	while (*s)
+		hal_tx2(*s++);
+}
+
+static void prof_putu(uint16_t n)
+{
+	uint16_t d = 10000;
+
+	while (d > 1 && n < d)
+		d /= 10;
+	for (; d; d /= 10)
+		hal_tx2('0' + (n / d) % 10);
+}
+#endif
+
+/*!
+ * \brief Function sends the table, one line per probe:
+ *	disp n=1234 min=12 avg=34 max=567 us
+ */
+void prof_dump(void)
+{
+#if PROFILE_UART
+	uint8_t i;
+	prof_t e;
+
+	for (i = 0; i < PROF_PROBES; i++) {
+		if (!prof_get(i, &e))
+			continue;
+		prof_puts(prof_names[i]);
+		prof_puts(" n=");
+		prof_putu(e.count);
+		prof_puts(" min=");
+		prof_putu(prof_us(e.min));
+		prof_puts(" avg=");
+		prof_putu(prof_us(e.total / e.count));
+		prof_puts(" max=");
+		prof_putu(prof_us(e.max));
+		prof_puts(" us\r\n");
+	}
+#endif
+}
+#endif
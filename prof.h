@@ -0,0 +1,46 @@
+/*
+ * File:   prof.h
+ *
+ * Cycle profiler: PROF_BEGIN/PROF_END around a hot path count Timer3
+ * ticks per probe. Without PROFILE the macros compile to nothing.
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* probes */
+#define PROF_GETTIME	0		/* getTime() */
+#define PROF_DISPLAY	1		/* display() */
+#define PROF_LCD_WRITE	2		/* lcd_write() */
+#define PROF_KEYS	3		/* takeKey() */
+#define PROF_PROBES	4
+
+/* one probe, times in Timer3 ticks */
+typedef struct {
+	uint16_t count;			/* saturates at 0xffff */
+	uint16_t min;
+	uint16_t max;
+	uint32_t total;
+} prof_t;
+
+#if PROFILE
+#define PROF_BEGIN(p)	prof_begin(p)
+#define PROF_END(p)	prof_end(p)
+
+void prof_init(void);			/* Start Timer3, calibrate the probes */
+void prof_begin(uint8_t);
+void prof_end(uint8_t);
+void prof_reset(void);			/* Clear the table */
+uint8_t prof_get(uint8_t, prof_t *);	/* Copy a probe, 0 if never hit */
+const char *prof_name(uint8_t);		/* 4 character name of a probe */
+uint16_t prof_us(uint32_t);		/* Ticks to us */
+void prof_dump(void);			/* Table to EUSART2 (PROFILE_UART) */
+#else
+#define PROF_BEGIN(p)
+#define PROF_END(p)
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * File:   pt.h
+ *
+ * Protothreads: stackless threads for multi-step flows on top of the
+ * scheduler. The state is the line number to continue from, so local
+ * variables of a protothread must be static and PT_xxx macros must not
+ * be used inside a switch statement of the protothread body.
+ */
+
+#ifndef PT_H
+#define PT_H
+
+#include <stdint.h>
+
+typedef uint16_t pt_t;
+
+#define PT_BEGIN(pt)		switch (*(pt)) { case 0:
+#define PT_END(pt)		} *(pt) = 0
+
+/* return to the scheduler, continue here on the next run */
+#define PT_YIELD(pt)		do { *(pt) = __LINE__; return; case __LINE__: ; } while (0)
+
+/* return to the scheduler until condition c holds */
+#define PT_WAIT_UNTIL(pt, c)	do { *(pt) = __LINE__; case __LINE__: if (!(c)) return; } while (0)
+
+/* start over on the next run */
+#define PT_RESTART(pt)		do { *(pt) = 0; return; } while (0)
+
+#endif
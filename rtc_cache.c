@@ -0,0 +1,249 @@
+/*
+ * File:   rtc_cache.c
+ *
+ * Register shadow of the PCF8583 (see rtc_cache.h). The control register
+ * only changes when it is written, so it is known after the first read or
+ * write. The time registers are valid from a read until RTC_MARGIN ms
+ * before the rollover the hundredths predict: the hundredth read may
+ * already be almost over and the 1 ms tick jitters, so the reads around
+ * the second boundary always reach the chip. With counting stopped
+ * (control bit 7) the shadow stays valid until rtc_cache_drop().
+ *
+ * Bus bytes of a read of all registers: address W, word address,
+ * address R, 5 data = 8. Of a burst write: address W, word address, data.
+ */
+
+#include "hal.h"
+
+#include "rtc_cache.h"
+#if I2C_ASYNC
+#include "i2c_async.h"
+#endif
+
+#define RTC_CTRL	0			/* control register */
+#define RTC_HSEC	1			/* hundredths, BCD */
+#define RTC_STOP	0x80			/* control: counting stopped */
+#define RTC_TIME	0x1e			/* registers 1 .. 4 */
+#define RTC_MARGIN	20			/* ms, shadow expires before the rollover */
+
+static i2c_dev_t *rtc_dev;
+static uint8_t shadow[RTC_REGS];
+static uint8_t dirty;				/* bit n = register n to write */
+static uint8_t known;				/* control register is known */
+static uint8_t valid;				/* time registers are known */
+static tick_t t_sync;				/* tick of shadow[RTC_HSEC] */
+static tick_t t_end;				/* tick the time registers expire */
+static rtc_cache_stat_t stat;
+
+#if I2C_ASYNC
+static i2c_xfer_t wr = { 0, 0, I2C_XFER_WRITE, 0, 0, 0, I2C_XFER_IDLE };
+#endif
+
+static uint8_t bcd_bin(uint8_t v)
+{
+	return ((v >> 4) * 10 + (v & 0x0f));
+}
+
+static uint8_t bin_bcd(uint8_t v)
+{
+	return (((v / 10) << 4) | (v % 10));
+}
+
+/*!
+ * \brief Function takes the hundredths of the shadow as read at tick t
+ */
+static void rtc_cache_sync(tick_t t)
+{
+	int16_t left = (100 - bcd_bin(shadow[RTC_HSEC])) * 10 - RTC_MARGIN;
+
+	t_sync = t;
+	t_end = t + left;
+	valid = left > 0 || (shadow[RTC_CTRL] & RTC_STOP);
+}
+
+/*!
+ * \brief Function tests whether the time registers are still valid
+ */
+static uint8_t rtc_cache_valid(void)
+{
+	if (valid && !(shadow[RTC_CTRL] & RTC_STOP) && sched_reached(t_end))
+		valid = 0;
+	return (valid);
+}
+
+/*!
+ * \brief Function moves the hundredths of the shadow to the current tick
+ */
+static void rtc_cache_advance(void)
+{
+	uint8_t n;
+
+	if (shadow[RTC_CTRL] & RTC_STOP)
+		return;
+	n = (tick_t)(sched_ticks() - t_sync) / 10;
+	shadow[RTC_HSEC] = bin_bcd(bcd_bin(shadow[RTC_HSEC]) + n);
+	t_sync += n * 10;
+}
+
+/*!
+ * \brief Function writes n registers of the shadow from register first
+ *
+ * \return	0 .. NoACK, 1 .. OK
+ */
+static uint8_t rtc_cache_write(uint8_t first, uint8_t n)
+{
+	stat.writes++;
+	stat.wr_bytes += 1 + rtc_dev->reg_width + n;
+#if I2C_ASYNC
+	wr.dev = rtc_dev;				/* through the queue, a read may be on the bus */
+	wr.reg = first;
+	wr.len = n;
+	wr.buf = &shadow[first];
+	i2c_async_submit(&wr);
+	i2c_async_wait(&wr);
+	return (wr.status == I2C_XFER_DONE);
+#else
+	return (i2c_dev_write(rtc_dev, first, &shadow[first], n));
+#endif
+}
+
+/*!
+ * \brief Function sets the device of the RTC, nothing is known of it yet
+ *
+ * \param *d	PCF8583
+ */
+void rtc_cache_init(i2c_dev_t *d)
+{
+	rtc_dev = d;
+	dirty = 0;
+	known = 0;
+	valid = 0;
+}
+
+/*!
+ * \brief Function copies the registers from the shadow while it is valid
+ *
+ * \param *r	Memory for RTC_REGS registers
+ * \return	0 .. the chip has to be read, 1 .. r filled
+ */
+uint8_t rtc_cache_get(uint8_t *r)
+{
+	uint8_t i;
+
+	if (!rtc_cache_valid())
+		return (0);
+	rtc_cache_advance();
+	for (i = 0; i < RTC_REGS; i++)
+		r[i] = shadow[i];
+	stat.hits++;
+	return (1);
+}
+
+/*!
+ * \brief Function takes registers read from the chip into the shadow,
+ * registers waiting to be written keep their new value
+ *
+ * \param *r	RTC_REGS registers
+ * \param t	Tick before the read started
+ */
+void rtc_cache_fill(const uint8_t *r, tick_t t)
+{
+	uint8_t i;
+
+	for (i = 0; i < RTC_REGS; i++)
+		if (!(dirty & (1 << i)))
+			shadow[i] = r[i];
+	known = 1;
+	rtc_cache_sync(t);
+	stat.reads++;
+	stat.rd_bytes += 2 + rtc_dev->reg_width + RTC_REGS;
+}
+
+/*!
+ * \brief Function reads the registers from the shadow or from the chip,
+ * blocking
+ *
+ * \param *r	Memory for RTC_REGS registers
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t rtc_cache_read(uint8_t *r)
+{
+	tick_t t;
+
+	if (rtc_cache_get(r))
+		return (1);
+	t = sched_ticks();
+	if (!i2c_dev_read(rtc_dev, 0, r, RTC_REGS))
+		return (0);
+	rtc_cache_fill(r, t);
+	return (1);
+}
+
+/*!
+ * \brief Function forgets the time registers, the next read goes to the
+ * chip. Must be called at least every 30 s while nothing is read (tick
+ * comparison range).
+ */
+void rtc_cache_drop(void)
+{
+	valid = 0;
+}
+
+/*!
+ * \brief Function sets a register in the shadow, it is marked dirty
+ * unless the chip holds the value already
+ *
+ * \param reg	Register 0 .. RTC_REGS - 1
+ * \param v	New value
+ */
+void rtc_cache_set(uint8_t reg, uint8_t v)
+{
+	if (rtc_cache_valid())
+		rtc_cache_advance();
+	if ((reg == RTC_CTRL ? known : valid) && shadow[reg] == v)
+		return;
+	shadow[reg] = v;
+	dirty |= 1 << reg;
+}
+
+/*!
+ * \brief Function writes the dirty registers, every run of adjacent ones
+ * in one transaction. Written hundredths or control restart the second
+ * of the shadow.
+ *
+ * \return	0 .. NoACK, shadow dropped, 1 .. OK
+ */
+uint8_t rtc_cache_flush(void)
+{
+	uint8_t first, n, ok = 1;
+
+	for (first = 0; first < RTC_REGS; first += n) {
+		for (n = 0; first + n < RTC_REGS && (dirty & (1 << (first + n))); n++);
+		if (!n)
+			n = 1;				/* clean register */
+		else if (!rtc_cache_write(first, n))
+			ok = 0;
+	}
+	if (dirty & (1 << RTC_CTRL))
+		known = 1;
+	if ((dirty & RTC_TIME) == RTC_TIME)
+		valid = 1;
+	if (valid && (dirty & ((1 << RTC_CTRL) | (1 << RTC_HSEC))))
+		rtc_cache_sync(sched_ticks());
+	dirty = 0;
+	if (!ok) {
+		known = 0;
+		valid = 0;
+	}
+	return (ok);
+}
+
+/*!
+ * \brief Function copies the counters
+ *
+ * \param *s	Memory for the counters
+ */
+void rtc_cache_stats(rtc_cache_stat_t *s)
+{
+	*s = stat;
+}
@@ -0,0 +1,40 @@
+/*
+ * File:   rtc_cache.h
+ *
+ * Shadow of the PCF8583 clock registers 0x00 .. 0x04: control,
+ * hundredths, seconds, minutes, hours (the _RTC of yunimain.c). A read is
+ * served from the shadow while the second it holds has not ended, the
+ * hundredths follow the 1 ms tick. A write marks only the registers which
+ * differ from the chip dirty, rtc_cache_flush() sends every run of
+ * adjacent dirty registers as one burst. Bus bytes are counted per
+ * operation.
+ */
+
+#ifndef RTC_CACHE_H
+#define RTC_CACHE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "sched.h"
+#include "i2c_dev.h"
+
+#define RTC_REGS	5		/* registers 0x00 .. 0x04 */
+
+typedef struct {
+	uint16_t reads;			/* reads on the bus */
+	uint16_t hits;			/* reads served from the shadow */
+	uint16_t writes;		/* burst writes */
+	uint32_t rd_bytes;		/* bus bytes of the reads incl. addresses */
+	uint32_t wr_bytes;		/* bus bytes of the writes incl. addresses */
+} rtc_cache_stat_t;
+
+void rtc_cache_init(i2c_dev_t *);		/* Device of the RTC, shadow empty */
+uint8_t rtc_cache_get(uint8_t *);		/* Registers from the shadow, 0 = read the chip */
+void rtc_cache_fill(const uint8_t *, tick_t);	/* Registers read from the chip at tick */
+uint8_t rtc_cache_read(uint8_t *);		/* Registers from the shadow or the chip, 0 = NoACK */
+void rtc_cache_drop(void);			/* Forget the time registers */
+void rtc_cache_set(uint8_t, uint8_t);		/* New value of a register */
+uint8_t rtc_cache_flush(void);			/* Write the dirty registers, 0 = NoACK */
+void rtc_cache_stats(rtc_cache_stat_t *);	/* Counters since start */
+
+#endif
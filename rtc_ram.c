@@ -0,0 +1,227 @@
+/*
+ * File:   rtc_ram.c
+ *
+ * Storage layer in the RAM of the PCF8583 (see rtc_ram.h). Every access
+ * is one transaction: without I2C_ASYNC i2c_dev_read()/i2c_dev_write()
+ * run it on I2C_Read_Block()/I2C_Write_Block(); with I2C_ASYNC it is
+ * queued by i2c_async_submit() behind a read of the clock that may be on
+ * the bus and i2c_async_wait() blocks until it ends, at most until its
+ * deadline (a stuck bus fails the access, see i2c_async.c). A mode costs
+ * 4 bytes on the bus, an event 2 writes of 6 and 5 bytes, about 1.1 ms at
+ * 100 kHz. An event is written before the log header, a reset in between
+ * loses the event but never leaves a header pointing at a half written
+ * one. The header is kept in memory after rtc_ram_valid() or
+ * rtc_ram_format().
+ */
+
+#include "hal.h"
+
+#include "rtc_ram.h"
+#if I2C_ASYNC
+#include "i2c_async.h"
+#endif
+
+#define RAM_SIG		0x10			/* boot signature */
+#define RAM_MODE	0x12			/* mode, ~mode */
+#define RAM_HDR		0x14			/* head, count, check */
+#define RAM_LOG		0x18			/* events */
+#define HDR_CHECK(h, c)	((h) ^ (c) ^ 0xa5)
+
+static const uint8_t sig[2] = { 0x59, 0x4b };
+
+static i2c_dev_t *ram_dev;
+static uint8_t head;				/* next event */
+static uint8_t count;				/* events in the log */
+
+#if I2C_ASYNC
+static i2c_xfer_t ram_xfer = { 0, 0, I2C_XFER_WRITE, 0, 0, 0, I2C_XFER_IDLE };
+
+/*!
+ * \brief Function runs one transaction through the queue, a read of the
+ * clock may be on the bus
+ */
+static uint8_t rtc_ram_xfer(uint8_t dir, uint8_t addr, uint8_t *buf, uint8_t len)
+{
+	ram_xfer.dev = ram_dev;
+	ram_xfer.reg = addr;
+	ram_xfer.dir = dir;
+	ram_xfer.len = len;
+	ram_xfer.buf = buf;
+	i2c_async_submit(&ram_xfer);
+	i2c_async_wait(&ram_xfer);
+	return (ram_xfer.status == I2C_XFER_DONE);
+}
+#endif
+
+/*!
+ * \brief Function sets the device of the RTC
+ *
+ * \param *d	PCF8583
+ */
+void rtc_ram_init(i2c_dev_t *d)
+{
+	ram_dev = d;
+	head = 0;
+	count = 0;
+}
+
+/*!
+ * \brief Function reads bytes of the RAM, blocking
+ *
+ * \param addr	First address
+ * \param *buf	Memory for the data
+ * \param len	Number of bytes
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t rtc_ram_read(uint8_t addr, uint8_t *buf, uint8_t len)
+{
+#if I2C_ASYNC
+	return (rtc_ram_xfer(I2C_XFER_READ, addr, buf, len));
+#else
+	return (i2c_dev_read(ram_dev, addr, buf, len));
+#endif
+}
+
+/*!
+ * \brief Function writes bytes of the RAM in one transaction, blocking
+ *
+ * \param addr	First address
+ * \param *buf	Data
+ * \param len	Number of bytes
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t rtc_ram_write(uint8_t addr, const uint8_t *buf, uint8_t len)
+{
+#if I2C_ASYNC
+	return (rtc_ram_xfer(I2C_XFER_WRITE, addr, (uint8_t *)buf, len));
+#else
+	return (i2c_dev_write(ram_dev, addr, buf, len));
+#endif
+}
+
+/*!
+ * \brief Function tests the signature of a previous cold start and loads
+ * the log header, a bad header means an empty log
+ *
+ * \return	0 .. RAM lost (or NoACK), 1 .. RAM kept
+ */
+uint8_t rtc_ram_valid(void)
+{
+	uint8_t r[7];
+
+	head = 0;
+	count = 0;
+	if (!rtc_ram_read(RAM_SIG, r, 7) || r[0] != sig[0] || r[1] != sig[1])
+		return (0);
+	if (r[4] < RTC_LOG_SIZE && r[5] <= RTC_LOG_SIZE && r[6] == HDR_CHECK(r[4], r[5])) {
+		head = r[4];
+		count = r[5];
+	}
+	return (1);
+}
+
+/*!
+ * \brief Function writes the signature, no mode and an empty log in one
+ * transaction
+ *
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t rtc_ram_format(void)
+{
+	uint8_t w[7];
+
+	head = 0;
+	count = 0;
+	w[0] = sig[0];
+	w[1] = sig[1];
+	w[2] = 0;					/* mode 0 with check 0 = no mode */
+	w[3] = 0;
+	w[4] = 0;
+	w[5] = 0;
+	w[6] = HDR_CHECK(0, 0);
+	return (rtc_ram_write(RAM_SIG, w, 7));
+}
+
+/*!
+ * \brief Function reads the display mode stored last
+ *
+ * \param *mode	Mode, unchanged if there is none
+ * \return	0 .. none, 1 .. mode read
+ */
+uint8_t rtc_ram_get_mode(uint8_t *mode)
+{
+	uint8_t r[2];
+
+	if (!rtc_ram_read(RAM_MODE, r, 2) || r[1] != (uint8_t)~r[0])
+		return (0);
+	*mode = r[0];
+	return (1);
+}
+
+/*!
+ * \brief Function stores the display mode
+ *
+ * \param mode	Mode
+ * \return	0 .. NoACK, 1 .. OK
+ */
+uint8_t rtc_ram_set_mode(uint8_t mode)
+{
+	uint8_t w[2];
+
+	w[0] = mode;
+	w[1] = ~mode;
+	return (rtc_ram_write(RAM_MODE, w, 2));
+}
+
+/*!
+ * \brief Function adds an event to the log, the oldest one is overwritten
+ * when it is full
+ *
+ * \param type	RTC_EV_xxx
+ * \param *time	Seconds, minutes, hours registers
+ * \return	0 .. NoACK, event lost, 1 .. OK
+ */
+uint8_t rtc_ram_log(uint8_t type, const uint8_t *time)
+{
+	uint8_t w[4];
+
+	w[0] = type;
+	w[1] = time[0];
+	w[2] = time[1];
+	w[3] = time[2];
+	if (!rtc_ram_write(RAM_LOG + head * sizeof(rtc_event_t), w, 4))
+		return (0);
+	if (++head == RTC_LOG_SIZE)
+		head = 0;
+	if (count < RTC_LOG_SIZE)
+		count++;
+	w[0] = head;
+	w[1] = count;
+	w[2] = HDR_CHECK(head, count);
+	return (rtc_ram_write(RAM_HDR, w, 3));
+}
+
+/*!
+ * \brief Function returns the number of events in the log
+ */
+uint8_t rtc_ram_log_count(void)
+{
+	return (count);
+}
+
+/*!
+ * \brief Function reads an event of the log
+ *
+ * \param i	0 .. newest, count - 1 .. oldest
+ * \param *e	Memory for the event
+ * \return	0 .. no such event (or NoACK), 1 .. OK
+ */
+uint8_t rtc_ram_log_get(uint8_t i, rtc_event_t *e)
+{
+	uint8_t slot;
+
+	if (i >= count)
+		return (0);
+	slot = (head + RTC_LOG_SIZE - 1 - i) % RTC_LOG_SIZE;
+	return (rtc_ram_read(RAM_LOG + slot * sizeof(rtc_event_t), (uint8_t *)e, sizeof(rtc_event_t)));
+}
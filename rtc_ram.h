@@ -0,0 +1,48 @@
+/*
+ * File:   rtc_ram.h
+ *
+ * Battery backed RAM of the PCF8583 (0x10 .. 0xFF) as persistent state
+ * which is written at bus speed, without the erase/write time of the
+ * EEPROM:
+ *
+ *	0x10	boot signature 59h 4Bh, written by a cold start
+ *	0x12	display mode, its complement
+ *	0x14	event log: next entry, entries, check byte
+ *	0x18	RTC_LOG_SIZE events of 4 bytes: type, seconds, minutes,
+ *		hours (BCD, the order of the clock registers)
+ *
+ * The content only counts while the signature is there, rtc_ram_format()
+ * starts a new RAM with an empty log.
+ */
+
+#ifndef RTC_RAM_H
+#define RTC_RAM_H
+
+#include <stdint.h>
+#include "config.h"
+#include "i2c_dev.h"
+
+#define RTC_LOG_SIZE	58		/* events, 0x18 .. 0xFF */
+
+#define RTC_EV_SET	1		/* time set, the new time */
+#define RTC_EV_STOP	2		/* clock stopped, the time shown */
+
+typedef struct {
+	uint8_t type;			/* RTC_EV_xxx */
+	uint8_t seconds;		/* BCD */
+	uint8_t minutes;
+	uint8_t hours;
+} rtc_event_t;
+
+void rtc_ram_init(i2c_dev_t *);				/* Device of the RTC */
+uint8_t rtc_ram_read(uint8_t, uint8_t *, uint8_t);	/* Read RAM bytes, 0 = NoACK */
+uint8_t rtc_ram_write(uint8_t, const uint8_t *, uint8_t);	/* Write RAM bytes, 0 = NoACK */
+uint8_t rtc_ram_valid(void);			/* Signature found, log header loaded */
+uint8_t rtc_ram_format(void);			/* Signature, no mode, empty log, 0 = NoACK */
+uint8_t rtc_ram_get_mode(uint8_t *);		/* Stored display mode, 0 = none */
+uint8_t rtc_ram_set_mode(uint8_t);		/* Store the display mode, 0 = NoACK */
+uint8_t rtc_ram_log(uint8_t, const uint8_t *);	/* Add an event (type, seconds .. hours) */
+uint8_t rtc_ram_log_count(void);		/* Events in the log */
+uint8_t rtc_ram_log_get(uint8_t, rtc_event_t *);	/* Event, 0 = newest, 0 = none */
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * File:   sched.c
+ *
+ * Cooperative scheduler. Timer4 generates the 1 ms system tick; a task
+ * runs when its due time is reached or when it was triggered (e.g. from
+ * an interrupt handler). When no task is ready the CPU waits for the next
+ * interrupt in power_idle(), so the main loop never busy-waits.
+ *
+ * Every task records the worst lateness (start time minus due time), which
+ * together with its period bounds the reaction time of the firmware.
+ */
+
+#include "hal.h"
+
+#include "sched.h"
+#include "power.h"
+
+/* Timer4: Fosc/4 / 16 / 250 (/ postscaler) = 1 kHz */
+#if _XTAL_FREQ == 64000000UL
+#define SCHED_T4CON	0b00011110	// 1:4 postscaler, on, 1:16 prescaler
+#elif _XTAL_FREQ == 16000000UL
+#define SCHED_T4CON	0b00000110	// 1:1 postscaler, on, 1:16 prescaler
+#else
+#error "sched: unsupported _XTAL_FREQ"
+#endif
+#define SCHED_PR4	249
+
+#define TASK_OFF	0		/* not scheduled */
+#define TASK_TIMED	1		/* runs at due */
+
+typedef struct {
+	task_fn fn;
+	uint16_t period;		/* ms, 0 = one-shot */
+	tick_t due;			/* tick of next run */
+	uint8_t state;			/* TASK_xxx */
+	volatile uint8_t ready;		/* triggered, run as soon as possible */
+	uint16_t late;			/* worst lateness in ms */
+} task_t;
+
+static task_t tasks[SCHED_TASKS];
+static uint8_t ntasks = 0;
+static volatile tick_t ticks = 0;
+
+/*!
+ * \brief Configure Timer4 for the 1 ms tick
+ */
+void sched_init(void)
+{
+	PR4 = SCHED_PR4;
+	TMR4 = 0;
+	T4CON = SCHED_T4CON;
+	PIR5bits.TMR4IF = 0;
+	PIE5bits.TMR4IE = 1;
+}
+
+/*!
+ * \brief Timer4 interrupt handler
+ *
+ * \return 1	A tick has passed
+ */
+uint8_t sched_isr(void)
+{
+	if (PIE5bits.TMR4IE && PIR5bits.TMR4IF) {
+		PIR5bits.TMR4IF = 0;
+		ticks++;
+		return (1);
+	}
+	return (0);
+}
+
+/*!
+ * \brief Milliseconds since sched_init(), wraps around
+ */
+tick_t sched_ticks(void)
+{
+	tick_t t;
+
+	PIE5bits.TMR4IE = 0;		/* 16 bit read is not atomic */
+	t = ticks;
+	PIE5bits.TMR4IE = 1;
+	return (t);
+}
+
+/*!
+ * \brief Function adds a task
+ *
+ * \param fn		Task function
+ * \param delay		First run after delay ms
+ * \param period	Period in ms, 0 = run once
+ * \return		Task id or SCHED_NONE if the table is full
+ */
+uint8_t sched_add(task_fn fn, uint16_t delay, uint16_t period)
+{
+	task_t *t;
+
+	if (ntasks == SCHED_TASKS)
+		return (SCHED_NONE);
+	t = &tasks[ntasks];
+	t->fn = fn;
+	t->period = period;
+	t->due = sched_ticks() + delay;
+	t->state = TASK_TIMED;
+	t->ready = 0;
+	t->late = 0;
+	return (ntasks++);
+}
+
+/*!
+ * \brief Function (re)schedules one run of a task after delay ms
+ */
+void sched_at(uint8_t id, uint16_t delay)
+{
+	if (id >= ntasks)
+		return;
+	tasks[id].due = sched_ticks() + delay;
+	tasks[id].state = TASK_TIMED;
+}
+
+/*!
+ * \brief Function marks a task ready, safe to call from interrupts
+ */
+void sched_trigger(uint8_t id)
+{
+	if (id < ntasks)
+		tasks[id].ready = 1;
+}
+
+/*!
+ * \brief Function cancels timed runs of a task
+ */
+void sched_stop(uint8_t id)
+{
+	if (id < ntasks)
+		tasks[id].state = TASK_OFF;
+}
+
+/*!
+ * \brief Worst lateness of a task in ms
+ */
+uint16_t sched_late(uint8_t id)
+{
+	return (id < ntasks ? tasks[id].late : 0);
+}
+
+/*!
+ * \brief Function runs the tasks forever
+ */
+void sched_run(void)
+{
+	uint8_t i, ran, timed;
+	task_t *t;
+	tick_t now;
+	uint16_t late;
+
+	while (1) {
+		ran = 0;
+		timed = 0;
+		for (i = 0; i < ntasks; i++) {
+			t = &tasks[i];
+			now = sched_ticks();
+			if (t->ready) {
+				t->ready = 0;
+			} else if (t->state == TASK_TIMED && (int16_t)(now - t->due) >= 0) {
+				late = now - t->due;
+				if (late > t->late)
+					t->late = late;
+				if (t->period) {
+					t->due += t->period;
+					if ((int16_t)(now - t->due) >= 0)
+						t->due = now + t->period;	/* do not catch up */
+				} else {
+					t->state = TASK_OFF;
+				}
+			} else {
+				continue;
+			}
+			t->fn();
+			ran = 1;
+		}
+		if (ran)
+			continue;
+		hal_irq_off();			/* no trigger may slip in */
+		for (i = 0; i < ntasks; i++) {
+			if (tasks[i].ready)
+				break;
+			if (tasks[i].state == TASK_TIMED)
+				timed = 1;
+		}
+		if (i == ntasks)
+			power_idle(timed);	/* wait for the next interrupt */
+		hal_irq_on();
+	}
+}
@@ -0,0 +1,33 @@
+/*
+ * File:   sched.h
+ *
+ * Cooperative scheduler driven by a 1 ms system tick (Timer4).
+ * Tasks are plain functions which must return quickly; multi-step flows
+ * are written as protothreads (pt.h) which yield back to the scheduler.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include "config.h"
+
+typedef void (*task_fn)(void);
+typedef uint16_t tick_t;		/* ms, wraps after 65 s */
+
+#define SCHED_NONE	0xff		/* no task / sched_add() failed */
+
+/* is tick t already reached ? (works across wrap for t up to 32 s ahead) */
+#define sched_reached(t)	((int16_t)(sched_ticks() - (t)) >= 0)
+
+void sched_init(void);				/* Start the 1 ms tick */
+tick_t sched_ticks(void);			/* Milliseconds since start */
+uint8_t sched_add(task_fn, uint16_t, uint16_t);	/* Add task (first run delay, period or 0), returns id */
+void sched_at(uint8_t, uint16_t);		/* Run task once after delay in ms */
+void sched_trigger(uint8_t);			/* Run task as soon as possible, ISR safe */
+void sched_stop(uint8_t);			/* Stop periodic / cancel pending run */
+uint16_t sched_late(uint8_t);			/* Worst delay from due time to start, ms */
+void sched_run(void);				/* Run tasks forever */
+uint8_t sched_isr(void);			/* Timer4 interrupt handler, 1 on tick */
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * File:   settings.c
+ *
+ * Settings store in the data EEPROM. A slot of 8 bytes holds one record:
+ *
+ *	0..1	sequence number (little endian), +1 with every record
+ *	2	SETTINGS_VERSION
+ *	3..5	settings_t
+ *	6..7	CRC-16/CCITT of bytes 0..5 (the _crc_ccitt_update() of
+ *		avr-libc), written last so a torn write leaves a bad record
+ *
+ * Records go round the slots in order, so the slots 0 .. k of the current
+ * lap hold consecutive sequence numbers counted from slot 0 and every
+ * other slot is older, erased or torn. The newest record is the end of
+ * that run, a binary search finds it in log2(SETTINGS_SLOTS) + 2 slot
+ * reads. A bad slot 0 means a torn write at the start of a lap (the last
+ * slot is the newest then) or an empty store.
+ *
+ * A write takes about 4 ms per byte; settings_task() starts one byte and
+ * comes back on the next tick until the EEPROM is done, bytes which are
+ * already right are skipped. With 100k erase/write cycles per byte the
+ * store takes SETTINGS_SLOTS * 100k records.
+ */
+
+#include "hal.h"
+
+#include "settings.h"
+#include "sched.h"
+
+#if SETTINGS
+
+#define SLOT		8				/* bytes per record */
+#define SLOT_DATA	6				/* bytes under the CRC */
+#define SLOT_ADDR(i)	(SETTINGS_BASE + (uint16_t)(i) * SLOT)
+#define IDLE		0xff				/* set_pos: no record being written */
+
+#if SETTINGS_BASE + SETTINGS_SLOTS * SLOT > 1024
+#error "settings do not fit into the 1 KB data EEPROM"
+#endif
+
+static uint8_t set_task = SCHED_NONE;
+static uint8_t set_slot = SETTINGS_SLOTS - 1;	/* slot of the newest record */
+static uint16_t set_seq = 0xffff;		/* its sequence number */
+static settings_t set_stored;			/* settings in the EEPROM */
+static settings_t set_next;			/* settings to write */
+static uint8_t set_pending = 0;			/* set_next differs from set_stored */
+static uint8_t set_img[SLOT];			/* record being written */
+static uint8_t set_pos = IDLE;			/* next byte of it */
+
+/*!
+ * \brief Function updates the CRC-16/CCITT (polynomial 0x8408 reflected)
+ */
+static uint16_t set_crc(uint16_t crc, uint8_t data)
+{
+	data ^= (uint8_t)crc;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+/*!
+ * \brief Function reads a slot and checks its record
+ *
+ * \param i	Slot
+ * \param *r	Memory for SLOT bytes
+ * \return	0 .. erased, torn or other version, 1 .. valid
+ */
+static uint8_t set_read(uint8_t i, uint8_t *r)
+{
+	uint16_t crc = 0xffff;
+	uint8_t j;
+
+	for (j = 0; j < SLOT; j++)
+		r[j] = hal_ee_read(SLOT_ADDR(i) + j);
+	for (j = 0; j < SLOT_DATA; j++)
+		crc = set_crc(crc, r[j]);
+	return (r[6] == (uint8_t)crc && r[7] == (uint8_t)(crc >> 8) &&
+	    r[2] == SETTINGS_VERSION);
+}
+
+static uint16_t set_rec_seq(const uint8_t *r)
+{
+	return (r[0] | ((uint16_t)r[1] << 8));
+}
+
+/*!
+ * \brief Function finds the newest valid record
+ *
+ * \param *s	Settings, the caller's defaults stay if there is no record
+ * \return	0 .. no record, 1 .. s loaded
+ */
+uint8_t settings_load(settings_t *s)
+{
+	uint8_t r[SLOT], lo, hi, mid;
+	uint16_t seq0;
+	uint8_t *p = (uint8_t *)s;
+
+	set_stored = *s;				/* an empty store holds the defaults */
+	set_next = *s;
+	if (set_read(0, r)) {
+		seq0 = set_rec_seq(r);
+		lo = 0;					/* slot lo is in the run */
+		hi = SETTINGS_SLOTS;			/* slot hi is not */
+		while (hi - lo > 1) {
+			mid = lo + (hi - lo) / 2;
+			if (set_read(mid, r) && set_rec_seq(r) == (uint16_t)(seq0 + mid))
+				lo = mid;
+			else
+				hi = mid;
+		}
+		if (!set_read(lo, r))
+			return (0);
+	} else if (set_read(SETTINGS_SLOTS - 1, r)) {
+		lo = SETTINGS_SLOTS - 1;		/* slot 0 torn */
+	} else {
+		return (0);				/* empty */
+	}
+	set_slot = lo;
+	set_seq = set_rec_seq(r);
+	for (mid = 0; mid < sizeof(settings_t); mid++)
+		p[mid] = r[3 + mid];
+	set_stored = *s;
+	set_next = *s;
+	return (1);
+}
+
+/*!
+ * \brief Function sets the task which writes the records
+ *
+ * \param task	Scheduler task of settings_task()
+ */
+void settings_init(uint8_t task)
+{
+	set_task = task;
+	if (set_pending)
+		sched_at(set_task, SETTINGS_DELAY_MS);	/* saved before the task existed */
+}
+
+/*!
+ * \brief Function takes new settings, the record is written when they
+ * did not change for SETTINGS_DELAY_MS
+ *
+ * \param *s	Settings
+ */
+void settings_save(const settings_t *s)
+{
+	const uint8_t *a = (const uint8_t *)s, *b = (const uint8_t *)&set_stored;
+	uint8_t i;
+
+	set_next = *s;
+	set_pending = 0;
+	for (i = 0; i < sizeof(settings_t); i++)
+		if (a[i] != b[i])
+			set_pending = 1;
+	if (set_pos == IDLE && set_pending)
+		sched_at(set_task, SETTINGS_DELAY_MS);	/* again from the last change */
+}
+
+/*!
+ * \brief Task function writes the pending record into the next slot
+ */
+void settings_task(void)
+{
+	uint16_t crc = 0xffff;
+	uint8_t i, slot;
+
+	if (set_pos == IDLE) {
+		if (!set_pending)
+			return;
+		set_pending = 0;
+		set_stored = set_next;
+		set_seq++;
+		set_img[0] = (uint8_t)set_seq;
+		set_img[1] = set_seq >> 8;
+		set_img[2] = SETTINGS_VERSION;
+		for (i = 0; i < sizeof(settings_t); i++)
+			set_img[3 + i] = ((uint8_t *)&set_stored)[i];
+		for (i = 0; i < SLOT_DATA; i++)
+			crc = set_crc(crc, set_img[i]);
+		set_img[6] = (uint8_t)crc;
+		set_img[7] = crc >> 8;
+		set_pos = 0;
+	}
+	slot = (set_slot + 1) % SETTINGS_SLOTS;
+	if (hal_ee_busy()) {
+		sched_at(set_task, 1);
+		return;
+	}
+	while (set_pos < SLOT && hal_ee_read(SLOT_ADDR(slot) + set_pos) == set_img[set_pos])
+		set_pos++;				/* already right */
+	if (set_pos < SLOT) {
+		hal_ee_write(SLOT_ADDR(slot) + set_pos, set_img[set_pos]);
+		set_pos++;
+		sched_at(set_task, 1);
+		return;
+	}
+	set_slot = slot;				/* record complete */
+	set_pos = IDLE;
+	if (set_pending)
+		sched_at(set_task, SETTINGS_DELAY_MS);
+}
+
+#endif /* SETTINGS */
@@ -0,0 +1,31 @@
+/*
+ * File:   settings.h
+ *
+ * Settings kept over a reset in the data EEPROM of PIC18F46K22. Every
+ * change is written as a new record into the next of SETTINGS_SLOTS
+ * slots (wear levelling), SETTINGS_DELAY_MS after the last change so a
+ * series of key presses costs one record. Records carry a sequence
+ * number, the format version and a CRC-16; at boot the newest valid one
+ * is found by a binary search over the slots.
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define SETTINGS_VERSION	1	/* format of settings_t */
+
+typedef struct {
+	uint8_t mode;			/* display mode (yunimain.c) */
+	uint8_t hours;			/* time of a cold start, BCD, as set last */
+	uint8_t minutes;
+} settings_t;
+
+uint8_t settings_load(settings_t *);	/* Newest valid record, 0 = none, defaults kept */
+void settings_init(uint8_t);		/* Task of settings_task(), starts the writes */
+void settings_save(const settings_t *);	/* New settings, written after SETTINGS_DELAY_MS */
+void settings_task(void);		/* Writes the record, one byte at a time */
+
+#endif
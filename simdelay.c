@@ -1,29 +1,105 @@
 /*
- *	Simple (uncalibrated) delay functions
+ *	Simple delay functions
+ *
+ *	Delays are timed by Timer0 running from Fosc/4 with the prescaler
+ *	chosen so that one tick is 1 us for the configured _XTAL_FREQ
+ *	(4, 8, 16, 32 or 64 MHz). The CPU waits in IDLE mode, interrupts of
+ *	other modules are served and the delay continues afterwards.
+ *
+ *	Accuracy: the call overhead is compensated, the error of one wait is
+ *	below 2 us plus the time spent in interrupt handlers which end after
+ *	the timer expires, i.e. < 1 % for Delay100Us(1) and more. The absolute
+ *	accuracy is that of the internal oscillator (+-2 %).
  *
- *	For precise delays, measure the result and tweak accordingly.
- * 
  *	Author: Martin Pavelek <he29@mail.muni.cz>
  *	Date:	2016-11-21
  */
 #include <stdint.h>
 //#include <delays.h>
-#include <pic18.h>
+#include "hal.h"
+#include "config.h"
+#include "simdelay.h"
+
+/* T0CON: timer off, 16 bit, Fosc/4, prescaler for 1 MHz tick */
+#if _XTAL_FREQ == 64000000UL
+#define DELAY_T0CON	0b00000011	// 1:16
+#elif _XTAL_FREQ == 32000000UL
+#define DELAY_T0CON	0b00000010	// 1:8
+#elif _XTAL_FREQ == 16000000UL
+#define DELAY_T0CON	0b00000001	// 1:4
+#elif _XTAL_FREQ == 8000000UL
+#define DELAY_T0CON	0b00000000	// 1:2
+#elif _XTAL_FREQ == 4000000UL
+#define DELAY_T0CON	0b00001000	// no prescaler
+#else
+#error "simdelay: unsupported _XTAL_FREQ"
+#endif
+
+/* cycles spent in delay_wait() outside of the timed interval, in us */
+#define DELAY_OVERHEAD	(30UL * 4000000UL / _XTAL_FREQ)
+
+/* longest single wait of the 16 bit timer */
+#define DELAY_MAX	60000U
 
-/* delay in 10*x us
- * @16 MHz clock, 0 gives about 6.3 us
+/*
+ * Wait us microseconds with Timer0, CPU in IDLE mode meanwhile
  */
-void Delay100Us(unsigned int x){   
-	unsigned int i;
-    //for (i=0; i<x; i++){_delay(18);}  // 1 MHz
-    for (i=0; i<x; i++){_delay(200);}   // 16 MHz   (0 gives about 6.3 us)
-    for (i=0; i<x; i++){_delay(200);}
-    //_delay(1);
-};
+static void delay_wait(uint16_t us)
+{
+	uint16_t t;
+	uint8_t ie;
 
-void DelayMs(unsigned int x){
-	unsigned int i;
-	for (i=0; i<x; i++){Delay100Us(10);}
+	if (us <= DELAY_OVERHEAD)
+		return;
+	t = (uint16_t)(0 - (us - DELAY_OVERHEAD));
+	T0CON = DELAY_T0CON;
+	TMR0H = t >> 8;			// TMR0H is written together with TMR0L
+	TMR0L = t & 0xff;
+	INTCONbits.TMR0IF = 0;
+	INTCONbits.TMR0IE = 1;		// overflow wakes the CPU
+	OSCCONbits.IDLEN = 1;		// SLEEP enters IDLE, timers keep running
+	T0CONbits.TMR0ON = 1;
+	/* the flag is tested with interrupts off: once delay_isr() has cleared
+	 * TMR0IE the overflow could no longer wake the CPU from SLEEP; a flag
+	 * pending with GIEH = 0 only wakes it, the handler runs afterwards */
+	ie = INTCONbits.GIEH;
+	for (;;) {
+		hal_irq_off();
+		if (INTCONbits.TMR0IF)
+			break;
+		hal_sleep();
+		if (ie)
+			hal_irq_on();		// the pending handler runs here
+	}
+	if (ie)
+		hal_irq_on();
+	T0CONbits.TMR0ON = 0;
+	INTCONbits.TMR0IE = 0;
 }
 
+/*
+ * Timer0 interrupt: only disable it, delay_wait() sees the flag
+ */
+void delay_isr(void)
+{
+	if (INTCONbits.TMR0IE && INTCONbits.TMR0IF)
+		INTCONbits.TMR0IE = 0;
+}
+
+/* delay in 100*x us
+ */
+void Delay100Us(unsigned int x){   
+	while (x > DELAY_MAX / 100) {
+		delay_wait(DELAY_MAX);
+		x -= DELAY_MAX / 100;
+	}
+	delay_wait(x * 100);
+}
 
+void DelayMs(unsigned int x){
+	while (x > DELAY_MAX / 1000) {
+		delay_wait(DELAY_MAX);
+		x -= DELAY_MAX / 1000;
+	}
+	delay_wait(x * 1000);
+}
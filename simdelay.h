@@ -2,10 +2,15 @@
 #define SIMDELAY_H
 
 #include <stdint.h>
+#include "config.h"
+#include "hal.h"
+
+/* short delay in us, x must be a constant (cycle exact, no timer) */
+#define DelayUs(x) hal_delay_us(x)
 
 void Delay100Us(unsigned int x);
 void DelayMs(unsigned int x);
+void delay_isr(void);
 
 #endif
 
-
@@ -0,0 +1,247 @@
+/*
+ * File:   timekeep.c
+ *
+ * Local timekeeping. Timer1 keeps the running time in RAM and triggers the
+ * display task every second, so no bus transaction is needed per redraw.
+ * The PCF8583 is read by the resync task every TIME_RESYNC_MIN minutes or
+ * on demand (tk_resync()); every resync measures the drift of the local
+ * time against the RTC and keeps it in a small log.
+ *
+ * Clock of Timer1 (LOCAL_TIME_SOSC):
+ *
+ *   1  32.768 kHz crystal on SOSC, Timer1 overflows every second (bit 15
+ *      is set back after each overflow) and runs in SLEEP too. SOSCO/SOSCI
+ *      are RC0/RC1, the LCD data lines D4/D5 of this board, so the LCD
+ *      has to be moved for this option.
+ *   0  Fosc/4 with 1:8 prescaler, the timer is reloaded to overflow every
+ *      62500 counts, TK_SUB overflows make a second. The accuracy is that
+ *      of the internal oscillator (about 1 %), which the resync corrects.
+ */
+
+#include "hal.h"
+
+#include "timekeep.h"
+#include "sched.h"
+
+#if LOCAL_TIME
+
+#if RTC_EVENT_DRIVEN
+#error "LOCAL_TIME replaces the 1 Hz RTC interrupt, disable RTC_EVENT_DRIVEN"
+#endif
+
+#if LOCAL_TIME_SOSC
+#warning "SOSC shares RC0/RC1 with the LCD data lines"
+#define TK_T1CON	0b10001101	/* SOSC, 1:1, oscillator on, async, on */
+#else
+#define TK_COUNTS	62500UL		/* timer counts per overflow */
+#define TK_RELOAD	(uint16_t)(65536UL - TK_COUNTS)
+#define TK_SUB		(uint8_t)(_XTAL_FREQ / 32 / TK_COUNTS)	/* overflows per second */
+#if _XTAL_FREQ % (32 * TK_COUNTS)
+#error "Fosc must be a multiple of 2 MHz for Timer1 timekeeping"
+#endif
+#define TK_T1CON	0b00110011	/* Fosc/4, 1:8, 16 bit, on */
+static uint8_t tk_sub = 0;		/* overflows in this second */
+#endif
+
+#define TK_DAY		8640000L	/* hundredths per day */
+
+static volatile uint8_t tk_time[3];	/* seconds, minutes, hours (BCD) */
+static volatile uint16_t tk_minutes = 0;	/* since the last resync */
+static uint8_t tk_second_task = SCHED_NONE;
+static uint8_t tk_sync_task = SCHED_NONE;
+static uint8_t tk_synced = 0;
+
+static tk_drift_t tk_log[TIME_LOG];
+static uint8_t tk_log_head = 0;		/* next entry to write */
+static uint8_t tk_log_n = 0;
+
+/*!
+ * \brief Increment BCD value, wrap to 0 at max
+ *
+ * \return 1	Value wrapped
+ */
+static uint8_t tk_bcd_inc(volatile uint8_t *v, uint8_t max)
+{
+	if (*v == max) {
+		*v = 0;
+		return (1);
+	}
+	if ((*v & 0x0f) == 9)
+		*v = (*v & 0xf0) + 0x10;
+	else
+		(*v)++;
+	return (0);
+}
+
+/*!
+ * \brief BCD registers (hundredths .. hours) to hundredths of the day
+ */
+static int32_t tk_hundredths(const uint8_t *r)
+{
+	uint8_t h = r[3] & 0x3f;
+	uint32_t s;
+
+	s = (uint32_t)((h >> 4) * 10 + (h & 0x0f)) * 3600
+	    + ((r[2] >> 4) * 10 + (r[2] & 0x0f)) * 60
+	    + (r[1] >> 4) * 10 + (r[1] & 0x0f);
+	return ((int32_t)(s * 100 + (r[0] >> 4) * 10 + (r[0] & 0x0f)));
+}
+
+/*!
+ * \brief Function starts Timer1 and its 1 Hz interrupt
+ *
+ * \param second	Task triggered every second
+ * \param sync		Task which reads the RTC and calls tk_sync()
+ */
+void tk_init(uint8_t second, uint8_t sync)
+{
+	tk_second_task = second;
+	tk_sync_task = sync;
+	T1CON = TK_T1CON;
+	T1GCON = 0;
+	PIR1bits.TMR1IF = 0;
+	PIE1bits.TMR1IE = 1;
+}
+
+/*!
+ * \brief Function sets the local time, the phase of Timer1 follows the
+ *	  hundredths
+ *
+ * \param *r	Hundredths, seconds, minutes, hours (BCD)
+ */
+void tk_set(const uint8_t *r)
+{
+	uint8_t hs = (r[0] >> 4) * 10 + (r[0] & 0x0f);
+	uint16_t t;
+
+	hal_irq_off();
+#if LOCAL_TIME_SOSC
+	t = 0x8000 + (uint16_t)(((uint32_t)hs << 15) / 100);
+#else
+	tk_sub = (uint8_t)((uint16_t)hs * TK_SUB / 100);
+	t = TK_RELOAD + (uint16_t)(((uint32_t)hs * TK_SUB % 100) * TK_COUNTS / 100);
+#endif
+	TMR1H = t >> 8;
+	TMR1L = (uint8_t)t;
+	PIR1bits.TMR1IF = 0;
+	tk_time[0] = r[1];
+	tk_time[1] = r[2];
+	tk_time[2] = r[3] & 0x3f;
+	tk_minutes = 0;
+	hal_irq_on();
+}
+
+/*!
+ * \brief Function reads the local time
+ *
+ * \param *r	Hundredths, seconds, minutes, hours (BCD)
+ */
+void tk_get(uint8_t *r)
+{
+	uint16_t t;
+	uint8_t hs;
+
+	hal_irq_off();
+	t = TMR1L;
+	t |= (uint16_t)TMR1H << 8;
+#if LOCAL_TIME_SOSC
+	hs = (uint8_t)(((uint32_t)(t & 0x7fff) * 100) >> 15);
+#else
+	hs = (uint8_t)(((uint32_t)tk_sub * TK_COUNTS + (uint16_t)(t - TK_RELOAD))
+	    / (TK_SUB * TK_COUNTS / 100));
+#endif
+	if (hs > 99)
+		hs = 99;
+	r[1] = tk_time[0];
+	r[2] = tk_time[1];
+	r[3] = tk_time[2];
+	hal_irq_on();
+	r[0] = (uint8_t)((hs / 10) << 4) | (hs % 10);
+}
+
+/*!
+ * \brief Function logs the drift of local time against RTC and takes
+ *	  over the RTC time
+ *
+ * \param *r	RTC hundredths, seconds, minutes, hours (BCD) just read
+ */
+void tk_sync(const uint8_t *r)
+{
+	uint8_t now[4];
+	int32_t d;
+
+	tk_get(now);
+	if (tk_synced) {
+		d = tk_hundredths(now) - tk_hundredths(r);
+		if (d > TK_DAY / 2)		/* across midnight */
+			d -= TK_DAY;
+		else if (d < -TK_DAY / 2)
+			d += TK_DAY;
+		if (d > INT16_MAX)
+			d = INT16_MAX;
+		else if (d < INT16_MIN)
+			d = INT16_MIN;
+		tk_log[tk_log_head].drift = (int16_t)d;
+		tk_log[tk_log_head].minutes = tk_minutes;
+		tk_log_head = (tk_log_head + 1) % TIME_LOG;
+		if (tk_log_n < TIME_LOG)
+			tk_log_n++;
+	}
+	tk_set(r);
+	tk_synced = 1;
+}
+
+/*!
+ * \brief Function asks for a resync with the RTC
+ */
+void tk_resync(void)
+{
+	sched_trigger(tk_sync_task);
+}
+
+/*!
+ * \brief Function returns an entry of the drift log
+ *
+ * \param i	0 = latest measurement
+ * \return 0	No such entry
+ */
+uint8_t tk_log_get(uint8_t i, tk_drift_t *d)
+{
+	if (i >= tk_log_n)
+		return (0);
+	*d = tk_log[(tk_log_head + TIME_LOG - 1 - i) % TIME_LOG];
+	return (1);
+}
+
+/*!
+ * \brief Timer1 interrupt handler, counts the seconds
+ */
+void tk_isr(void)
+{
+#if !LOCAL_TIME_SOSC
+	uint16_t t;
+#endif
+
+	if (!PIE1bits.TMR1IE || !PIR1bits.TMR1IF)
+		return;
+	PIR1bits.TMR1IF = 0;
+#if LOCAL_TIME_SOSC
+	TMR1H |= 0x80;				/* next overflow in 32768 counts */
+#else
+	t = TMR1L;				/* counts since the overflow stay */
+	t |= (uint16_t)TMR1H << 8;
+	t += TK_RELOAD;
+	TMR1H = t >> 8;
+	TMR1L = (uint8_t)t;
+	if (++tk_sub < TK_SUB)
+		return;
+	tk_sub = 0;
+#endif
+	if (tk_bcd_inc(&tk_time[0], 0x59) && tk_bcd_inc(&tk_time[1], 0x59))
+		tk_bcd_inc(&tk_time[2], 0x23);
+	if (tk_time[0] == 0 && ++tk_minutes >= TIME_RESYNC_MIN)
+		sched_trigger(tk_sync_task);
+	sched_trigger(tk_second_task);
+}
+
+#endif /* LOCAL_TIME */
@@ -0,0 +1,29 @@
+/*
+ * File:   timekeep.h
+ *
+ * Local timekeeping on Timer1, the PCF8583 is only read to resync.
+ * Time is passed as the PCF8583 registers 1..4: hundredths, seconds,
+ * minutes, hours (BCD, 24 h), e.g. tk_get(&RTC.milisecReg).
+ */
+
+#ifndef TIMEKEEP_H
+#define TIMEKEEP_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* one drift measurement */
+typedef struct {
+	int16_t drift;			/* local - RTC in 1/100 s, + = local is fast */
+	uint16_t minutes;		/* since the previous resync */
+} tk_drift_t;
+
+void tk_init(uint8_t, uint8_t);		/* Start Timer1 (task every second, resync task) */
+void tk_set(const uint8_t *);		/* Set local time */
+void tk_get(uint8_t *);			/* Read local time */
+void tk_sync(const uint8_t *);		/* Measure drift against RTC time and set */
+void tk_resync(void);			/* Resync as soon as possible */
+uint8_t tk_log_get(uint8_t, tk_drift_t *);	/* Drift log, 0 = latest */
+void tk_isr(void);			/* Timer1 interrupt handler */
+
+#endif
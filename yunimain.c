@@ -8,11 +8,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <xc.h>
+#include "hal.h"
 #include "simdelay.h"
 #include "display.h"
 #include "shift.h"
 #include "i2c2.h"
+#include "i2c_dev.h"
+#include "i2c_async.h"
+#include "bench.h"
+#include "sched.h"
+#include "pt.h"
+#include "buttons.h"
+#include "power.h"
+#include "timekeep.h"
+#include "prof.h"
+#include "align.h"
+#include "rtc_cache.h"
+#include "settings.h"
+#include "rtc_ram.h"
 
 #pragma config WDTEN = OFF
 #pragma config FOSC = INTIO7
@@ -34,6 +47,26 @@ typedef struct {
 
 _RTC RTC;
 
+/*
+ * PCF8583 on the bus: address 0xA0 (A0 pin low), 100 kHz, 8 bit word address
+ */
+i2c_dev_t rtcDev = I2C_DEV(0x50, I2C_SPEED_STD, 1);
+
+#if I2C_ASYNC
+/*
+ * Transactions of the RTC, reads land in rtcBuf and are copied to RTC by
+ * getTime() once finished, so display() never sees a half-updated time.
+ */
+uint8_t rtcBuf[5];
+void rtcReadDone(i2c_xfer_t *x);
+i2c_xfer_t rtcRead  = { &rtcDev, 0, I2C_XFER_READ,  5, rtcBuf, rtcReadDone, I2C_XFER_IDLE };
+#if RTC_CACHE
+uint8_t rtcHit = 0;             /* rtcBuf comes from the shadow */
+#else
+i2c_xfer_t rtcWrite = { &rtcDev, 0, I2C_XFER_WRITE, 5, &RTC.controlReg, 0, I2C_XFER_IDLE };
+#endif
+#endif
+
 /*
  * Values used for the first set up of the clock
  * T = tens  
@@ -52,19 +85,65 @@ uint8_t secondsD = 0;
  */
 uint8_t mode = 0;
 
+/*
+ * Scheduler tasks (see main())
+ */
+uint8_t tRtc, tDisplay, tUi;
+#if SETTINGS
+uint8_t tSettings;
+#endif
+
+/*
+ * Time of the last key press taken by the UI and the worst time from key
+ * press to updated screen in ms.
+ */
+tick_t keyTime;
+uint8_t keyPending = 0;
+uint16_t latencyMax = 0;
+
+/*
+ * UI owns the screen (time setting, messages), display task stays away
+ */
+uint8_t uiBusy = 0;
+#if !RTC_EVENT_DRIVEN
+uint8_t uiTiming = 0;           /* uiSecond() counts with the tick */
+tick_t uiNext;                  /* its next second */
+#endif
+
+/*
+ * Polled RTC reads follow the second boundary of the RTC (align.c), the
+ * frame of the next second waits in the frame buffer (see taskDisplay())
+ */
+#define ALIGN   (RTC_ALIGN && !RTC_EVENT_DRIVEN && !LOCAL_TIME)
+#if ALIGN || RTC_CACHE
+tick_t rtcReadTick;             /* start of the latest read */
+#endif
+#if ALIGN
+uint8_t nextFrame = 0;          /* frame buffer holds the next second */
+uint8_t nextSec;                /* its seconds register */
+#endif
+#if ALIGN && !I2C_ASYNC
+uint8_t rtcFresh = 0;           /* taskRtc has read the RTC */
+#endif
+
 void displayInit() {
-    TRISC = 0;
-    TRISEbits.RE2 = 0;
-    LATEbits.LE2 = 1;
+    hal_tris_write(C, 0);
+    hal_pin_dir(E, 2, 0);
+    hal_pin_write(E, 2, 1);
+#if BENCH_MARK
+    ANSELA &= 0b11111110;
+    hal_pin_write(A, 0, 0); /* latency marker */
+    hal_pin_dir(A, 0, 0);
+#endif
     lcd_init();
 }
 
 void rtcInit() {
-    TRISDbits.RD0 = 0;  /* serial clock -> output pin */
-    TRISDbits.RD1 = 0;  /* serial data  -> output pin */
-
-    LATDbits.LATD0 = 1; /* P_SCL_ON */
-    LATDbits.LATD0 = 1; /* P_SDA_ON */
+    I2C_Init();             /* SCL/SDA released, stuck slave freed */
+#if RTC_CACHE
+    rtc_cache_init(&rtcDev);
+#endif
+    rtc_ram_init(&rtcDev);
 
     RTC.controlReg = 0x80;                          /* Set control 32.768kHz */
     RTC.milisecReg = 0;                             /* Set begin time: ms */   
@@ -73,49 +152,325 @@ void rtcInit() {
     RTC.hoursReg   = (hoursT   << 4) | (hoursD);    /* Set begin time: hr */ 
 }
 
+#if RTC_EVENT_DRIVEN
+/*
+ * RTC INT (open drain) on RB5, interrupt-on-change of PORTB
+ */
+void rtcIntInit() {
+    WPUB |= 0b00100000;         /* weak pull-up for the open drain INT */
+    INTCON2bits.RBPU = 0;       /* PORTB pull-ups enabled */
+    IOCB = 0b00100000;          /* interrupt-on-change on RB5 only */
+    (void)hal_port(B);          /* end mismatch condition */
+    INTCONbits.RBIF = 0;
+    INTCONbits.RBIE = 1;
+}
+
+/*
+ * RB5 change handler, a new second is signalled on the falling edge.
+ * The PCF8583 outputs 1 Hz on INT while the alarm enable bit of its
+ * control register is 0, which is what main() writes.
+ */
+void rtcIntIsr() {
+    if(INTCONbits.RBIE && INTCONbits.RBIF) {
+        uint8_t b = hal_port(B); /* read ends the mismatch */
+        INTCONbits.RBIF = 0;
+        if(!(b & 0b00100000))
+            sched_trigger(tRtc);
+    }
+}
+#endif
+
 void init(){
+    power_init();                                   /* unused peripherals off */
     OSCCON = (OSCCON & 0b10001111) | 0b01110000;    /* internal oscillator at full speed (16 MHz) */
+    OSCTUNEbits.PLLEN = FOSC_PLL;                   /* 4x PLL -> 64 MHz */
 
-    TRISB = 0b11111111; /* five buttons in + unused + PGC, PGD */
-    LATB  = 0xff;       /* pull-up by default */
+    hal_tris_write(B, 0b11111111);  /* five buttons in + unused + PGC, PGD */
+    hal_lat_write(B, 0xff);         /* pull-up by default */
     ANSELB = 0;         /* no ADC inputs */
     
-    TRISD = 0b00000000; 
-    LATD  = 0b00000000;
+    hal_tris_write(D, 0b00000000);
+    hal_lat_write(D, 0b00000000);
     ANSELD = 0;
     
     RCONbits.IPEN = 1; //Allow interrupts 
     INTCONbits.GIEL = 1; //Allow low priority interrups 
+    hal_irq_on(); //Allow high priority interrups 
     
     displayInit();
     rtcInit();
+    sched_init();
+#if RTC_EVENT_DRIVEN
+    rtcIntInit();
+#endif
+#if PROFILE
+    prof_init();
+#endif
+}
+
+/*
+ * Interrupt service routine, every module checks its own flags
+ */
+void __interrupt() isr(void) {
+    if(sched_isr()) {
+        btn_tick();
+        power_tick();
+    }
+    btn_isr();
+    delay_isr();
+#if I2C_ASYNC
+    i2c_async_isr();
+#endif
+#if RTC_EVENT_DRIVEN
+    rtcIntIsr();
+#endif
+#if LOCAL_TIME
+    tk_isr();
+#endif
+#if LCD_QUEUED
+    lcd_isr();
+#endif
+}
+
+#if RTC_CACHE
+/*
+ * Hand RTC over to the shadow, only the registers which differ from the
+ * chip are written, adjacent ones in one transaction
+ */
+void rtcPut() {
+    uint8_t i;
+    uint8_t *ptr = &RTC.controlReg;
+
+    for (i = 0; i < RTC_REGS; i++)
+        rtc_cache_set(i, ptr[i]);
+    rtc_cache_flush();
+}
+#endif
+
+#if I2C_ASYNC
+/*
+ * Takes over the result of a finished RTC read.
+ * Returns 1 when RTC has been updated.
+ */
+uint8_t timeReady() {
+    uint8_t i;
+    uint8_t *ptr = &RTC.controlReg;
+
+    if (rtcRead.status != I2C_XFER_DONE)
+        return 0;
+    for (i = 0; i < 5; i++)
+        ptr[i] = rtcBuf[i];
+#if RTC_CACHE
+    if(!rtcHit)
+        rtc_cache_fill(rtcBuf, rtcReadTick);
+    rtcHit = 0;
+#endif
+    rtcRead.status = I2C_XFER_IDLE;
+    return 1;
+}
+
+/*
+ * Completion of the RTC read (called from ISR), new data for the display
+ */
+void rtcReadDone(i2c_xfer_t *x) {
+    (void)x;
+    sched_trigger(tDisplay);
 }
 
+/*
+ * Function for getting time data from RTC unit, non-blocking version.
+ * Takes over the result of the previous read and queues the next one,
+ * within the second of the shadow the result is there at once.
+ */
+void getTime() {
+    PROF_BEGIN(PROF_GETTIME);
+    timeReady();
+    if (rtcRead.status != I2C_XFER_QUEUED && rtcRead.status != I2C_XFER_BUSY) {
+#if ALIGN || RTC_CACHE
+        rtcReadTick = sched_ticks();
+#endif
+#if RTC_CACHE
+        rtcHit = rtc_cache_get(rtcBuf);
+        if(rtcHit) {
+            rtcRead.status = I2C_XFER_DONE;
+            sched_trigger(tDisplay);
+        }
+#endif
+        if(rtcRead.status != I2C_XFER_DONE)
+            i2c_async_submit(&rtcRead);
+    }
+    PROF_END(PROF_GETTIME);
+}
+
+/*
+ * Function for setting time data to RTC unit, waits for the write
+ * so the caller can change RTC right after.
+ */
+void setTime() {
+#if RTC_CACHE
+    rtcPut();
+    rtcHit = 0;
+#else
+    i2c_async_submit(&rtcWrite);
+    i2c_async_wait(&rtcWrite);
+#endif
+    if (rtcRead.status == I2C_XFER_DONE)
+        rtcRead.status = I2C_XFER_IDLE;     /* read before the write is stale */
+#if LOCAL_TIME
+    tk_set(&RTC.milisecReg);
+#endif
+}
+#else
 /*
  * Function for getting time data from RTC unit
  */
 void getTime() {
-    I2C_Stop();                           /* Generate stop condition */
-    I2C_Set_Address(0,0);                 /* Set RTC address to 0, func. write */
-    I2C_Start();
-    I2C_Set_Address(0,1);	              /* Set RTC address to 0, func. read */ 
-    I2C_Read_Block(5, &RTC.controlReg);   /* Read first 5 byte from RTC and store data */
-    I2C_Stop();                           /* Generate stop condition */
+    PROF_BEGIN(PROF_GETTIME);
+#if ALIGN
+    rtcReadTick = sched_ticks();
+#endif
+#if RTC_CACHE
+    rtc_cache_read(&RTC.controlReg);                /* shadow or first 5 registers */
+#else
+    i2c_dev_read(&rtcDev, 0, &RTC.controlReg, 5);   /* first 5 registers, one transaction */
+#endif
+    PROF_END(PROF_GETTIME);
 }
 
 /*
  * Function for setting time data to RTC unit
  */
 void setTime() {
-    uint8_t i;
-    uint8_t *ptr = &RTC.controlReg;       /* Set temporary pointer */
-    I2C_Stop();                           /* Generate stop */
-    I2C_Set_Address(0,0);                 /* Set low address and func, write */
-    for (i = 0; i < 5; i++) {
-	 I2C_Write_B(*ptr);                   /* Write 5 byte to RTC */
-	 ptr++;
+#if RTC_CACHE
+    rtcPut();
+#else
+    i2c_dev_write(&rtcDev, 0, &RTC.controlReg, 5);  /* Write 5 byte to RTC */
+#endif
+#if LOCAL_TIME
+    tk_set(&RTC.milisecReg);
+#endif
+}
+#endif
+
+#if RTC_WARM_START
+/*
+ * Check a BCD register value: both digits decimal, not above max
+ */
+uint8_t bcdValid(uint8_t v, uint8_t max) {
+    return (v & 0x0f) <= 9 && v <= max;
+}
+
+/*
+ * Take over the time of the RTC after a reset. The RTC must acknowledge
+ * its address, count a valid 24 h time in the clock mode and hold the
+ * signature in its RAM, otherwise it lost its backup supply. Runs before
+ * the scheduler, so the time is read directly even with I2C_ASYNC.
+ * Returns 0 when the RTC has to be set.
+ */
+uint8_t rtcResume() {
+    uint8_t r[5];
+#if RTC_CACHE
+    tick_t t = sched_ticks();
+#endif
+
+    if(!i2c_dev_read(&rtcDev, 0, r, 5) ||             /* RTC missing */
+       !rtc_ram_valid())
+        return 0;
+    if((r[0] & 0b11110100) ||             /* stopped, hold, mode, alarm */
+       !bcdValid(r[1], 0x99) || !bcdValid(r[2], 0x59) ||
+       !bcdValid(r[3], 0x59) || !bcdValid(r[4], 0x23))
+        return 0;
+    RTC.controlReg = r[0];
+    RTC.milisecReg = r[1];
+    RTC.secondsReg = r[2];
+    RTC.minutesReg = r[3];
+    RTC.hoursReg   = r[4];
+#if RTC_CACHE
+    rtc_cache_fill(r, t);
+#endif
+    return 1;
+}
+#endif
+
+#if SETTINGS
+/*
+ * Settings kept in the data EEPROM (settings.c): display mode and the
+ * time a cold start begins with, which is the time set last
+ */
+settings_t settings = { 0, 0x12, 0x00 };
+
+/*
+ * Take over the stored settings, before rtcStart() so that a cold start
+ * writes the stored time
+ */
+void loadSettings() {
+    settings_load(&settings);
+    mode = settings.mode;
+    hoursT   = settings.hours >> 4;
+    hoursD   = settings.hours & 0x0f;
+    minutesT = settings.minutes >> 4;
+    minutesD = settings.minutes & 0x0f;
+    RTC.hoursReg   = settings.hours;
+    RTC.minutesReg = settings.minutes;
+}
+#endif
+
+/*
+ * Start the clock: a warm start keeps the time of the RTC, a cold start
+ * writes the begin time with counting stopped and then starts it.
+ * Returns 1 on a warm start, RTC then holds the time just read.
+ */
+uint8_t rtcStart() {
+#if RTC_WARM_START
+    if(rtcResume()) {
+#if LOCAL_TIME
+        tk_set(&RTC.milisecReg);
+#endif
+#if RTC_RAM
+        rtc_ram_get_mode(&mode);        /* newer than the EEPROM */
+#if SETTINGS
+        settings.mode = mode;
+        settings_save(&settings);       /* no write if the same */
+#endif
+#endif
+        return 1;
     }
-    I2C_Stop();       
+#endif
+    setTime();
+    RTC.controlReg = 0;
+    setTime();
+#if RTC_WARM_START || RTC_RAM
+    rtc_ram_format();           /* signature, a reset before it leads to another cold start */
+#endif
+#if RTC_RAM
+    rtc_ram_set_mode(mode);
+#endif
+    return 0;
+}
+
+/*
+ * Display mode changed: kept in the RTC RAM at once, in the EEPROM once
+ * the presses stop
+ */
+void saveMode() {
+#if RTC_RAM
+    rtc_ram_set_mode(mode);
+#endif
+#if SETTINGS
+    settings.mode = mode;
+    settings_save(&settings);
+#endif
+}
+
+/*
+ * Add a time set / clock stop event with the time of RTC to the log
+ */
+void logEvent(uint8_t type) {
+#if RTC_RAM
+    rtc_ram_log(type, &RTC.secondsReg);
+#else
+    (void)type;
+#endif
 }
 
 /* 
@@ -128,187 +483,563 @@ void printBinary(uint8_t number) {
     uint8_t i;
     
     for(i = 0x8; i!= 0; i >>= 1)
-        lcd_putchar((number & i) ? '*':'o');
+        lcd_fb_putchar((number & i) ? '*':'o');
 }
 
 /*
- * Display time in selected mode.
- * mode 0 = regular clock; HH:MM:SS
- * mode 1 = binary print; bin minutesT | bin minutesD MM
- *                        bin secondsT | bin secondsD SS
+ * Interpret register values as HH:MM:SS
  */
-void display() {
-    uint8_t tmp = secondsD;
-    /* interpret register values as HH:MM:SS */
+void splitTime() {
     hoursT   = (RTC.hoursReg & 0b11110000) >> 4;
     hoursD   = RTC.hoursReg & 0b00001111;
     minutesT = (RTC.minutesReg & 0b11110000) >> 4;
     minutesD = RTC.minutesReg & 0b00001111;
     secondsT = (RTC.secondsReg & 0b11110000) >> 4;
     secondsD = RTC.secondsReg & 0b00001111;
+}
 
-    if(tmp != secondsD) { 
-        if(mode) {  
-        /* binary mode print */
-            /* minutes */
-            lcd_clear();
-            lcd_goto(0);
-            printBinary(minutesT);
-            lcd_putchar('|');
-            printBinary(minutesD);
-            lcd_putchar(' ');
-            lcd_putchar('0' + minutesT);
-            lcd_putchar('0' + minutesD);
-            
-            /* seconds */
-            lcd_goto(40);
-            printBinary(secondsT);
-            lcd_putchar('|');
-            printBinary(secondsD);
-            lcd_putchar(' ');
-            lcd_putchar('0' + secondsT);
-            lcd_putchar('0' + secondsD);
-        } else {
-        /* regular clock print */
-            lcd_clear();
-            lcd_goto(0);
-            lcd_putchar('0' + hoursT);
-            lcd_putchar('0' + hoursD);
-            lcd_putchar(':');
-            lcd_putchar('0' + minutesT);
-            lcd_putchar('0' + minutesD);
-            lcd_putchar(':');
-            lcd_putchar('0' + secondsT); 
-            lcd_putchar('0' + secondsD);
-        }
+/*
+ * Render time in selected mode into the frame buffer.
+ * mode 0 = regular clock; HH:MM:SS
+ * mode 1 = binary print; bin minutesT | bin minutesD MM
+ *                        bin secondsT | bin secondsD SS
+ */
+void render() {
+    splitTime();
+
+    if(mode) {  
+    /* binary mode print */
+        /* minutes */
+        lcd_fb_clear();
+        lcd_fb_goto(0);
+        printBinary(minutesT);
+        lcd_fb_putchar('|');
+        printBinary(minutesD);
+        lcd_fb_putchar(' ');
+        lcd_fb_putchar('0' + minutesT);
+        lcd_fb_putchar('0' + minutesD);
+        
+        /* seconds */
+        lcd_fb_goto(40);
+        printBinary(secondsT);
+        lcd_fb_putchar('|');
+        printBinary(secondsD);
+        lcd_fb_putchar(' ');
+        lcd_fb_putchar('0' + secondsT);
+        lcd_fb_putchar('0' + secondsD);
+    } else {
+    /* regular clock print */
+        lcd_fb_clear();
+        lcd_fb_goto(0);
+        lcd_fb_putchar('0' + hoursT);
+        lcd_fb_putchar('0' + hoursD);
+        lcd_fb_putchar(':');
+        lcd_fb_putchar('0' + minutesT);
+        lcd_fb_putchar('0' + minutesD);
+        lcd_fb_putchar(':');
+        lcd_fb_putchar('0' + secondsT); 
+        lcd_fb_putchar('0' + secondsD);
     }
 }
 
 /*
- * Help function for registering button presses
+ * Display time in selected mode
  */
-int pressedButton() {
-    if(!PORTBbits.RB0) {    
-        DelayMs(50);
-        if(!PORTBbits.RB0) return 0; /* BTN1 */
+void display() {
+    PROF_BEGIN(PROF_DISPLAY);
+    render();
+    lcd_fb_flush();     /* send only what changed */
+    PROF_END(PROF_DISPLAY);
+}
+
+#if ALIGN
+/*
+ * Increment BCD register, wrap to 0 after max, 1 on wrap
+ */
+uint8_t bcdInc(uint8_t *v, uint8_t max) {
+    if(*v >= max) {
+        *v = 0;
+        return 1;
     }
-    else if(!PORTBbits.RB1) {
-        DelayMs(50);
-        if(!PORTBbits.RB1) return 1; /* BTN2 */
+    *v = ((*v & 0x0f) == 9) ? (*v & 0xf0) + 0x10 : *v + 1;
+    return 0;
+}
+
+/*
+ * Render the frame of the next second, it is sent when the RTC gets there
+ */
+void prepareNext() {
+    _RTC now = RTC;
+
+    if(bcdInc(&RTC.secondsReg, 0x59) && bcdInc(&RTC.minutesReg, 0x59))
+        bcdInc(&RTC.hoursReg, 0x23);
+    render();
+    nextSec = RTC.secondsReg;
+    nextFrame = 1;
+    RTC = now;
+    splitTime();                /* digits of the time setting */
+}
+#endif
+
+/*
+ * Wall time of the duty counter while the UI holds the RTC, which is not
+ * read then: with RTC_EVENT_DRIVEN every run of taskRtc (rtc = 1) is an
+ * edge of the 1 Hz output, otherwise the scheduler tick counts
+ */
+void uiSecond(uint8_t rtc) {
+#if RTC_EVENT_DRIVEN
+    if(rtc)
+        power_second();
+#else
+    (void)rtc;
+    if(!uiTiming) {
+        uiTiming = 1;
+        uiNext = sched_ticks() + 1000;
     }
-    else if(!PORTBbits.RB2) {
-        DelayMs(50);
-        if(!PORTBbits.RB2) return 2; /* BTN3 */
+    while(sched_reached(uiNext)) {
+        uiNext += 1000;
+        power_second();
     }
-    return -1;                       /* no button */
+#endif
 }
 
 /*
- * Function for setting time on selected position (int pos), with time slot 
- * in register (uint8_t* valueReg) from 0 to maximum value (int max)
- * BTN1 to change value
- * BTN2 to confirm and move to next position
+ * RTC task: read the time, the display task follows. RTC is left alone
+ * while the UI works with the time. With LOCAL_TIME the task only runs
+ * to resync the Timer1 time. With ALIGN the display task plans the next
+ * read, the one planned here only keeps the task alive when it does not.
  */
-void readAndSet(int pos, uint8_t* valueReg, int max) {
+void taskRtc() {
+#if ALIGN
+    sched_at(tRtc, 1000);
+#endif
+#if I2C_ASYNC
+    i2c_async_check();          /* a stuck read must not stop the reads */
+#endif
+    if(uiBusy) {                /* stopped clock or time setting */
+#if RTC_CACHE
+        rtc_cache_drop();       /* the RTC goes on without us */
+#endif
+        uiSecond(1);
+        return;
+    }
+#if RTC_CACHE && LOCAL_TIME
+    rtc_cache_drop();           /* the resync has to read the RTC */
+#endif
+    getTime();
+#if !I2C_ASYNC
+#if LOCAL_TIME
+    tk_sync(&RTC.milisecReg);
+#endif
+#if ALIGN
+    rtcFresh = 1;
+#endif
+    sched_trigger(tDisplay);
+#endif
+}
+
+/*
+ * Display task: show the latest time unless the UI owns the screen.
+ * With ALIGN a fresh read plans the next one; a read of the old second
+ * leaves the prepared next frame alone, a read of the expected new
+ * second only sends it, anything else (key, UI done, time set) renders.
+ */
+void taskDisplay() {
+    static uint8_t lastSec = 0xff;
+#if ALIGN
+    uint8_t fresh, rolled;
+#endif
+
+    if(uiBusy) {                /* LOCAL_TIME: taskRtc only resyncs */
+        uiSecond(0);
+        return;
+    }
+#if !RTC_EVENT_DRIVEN
+    uiTiming = 0;
+#endif
+#if I2C_ASYNC && LOCAL_TIME
+    if(timeReady())             /* resync read finished */
+        tk_sync(&RTC.milisecReg);
+#elif I2C_ASYNC && ALIGN
+    fresh = timeReady();
+#elif I2C_ASYNC
+    timeReady();
+#elif ALIGN
+    fresh = rtcFresh;
+    rtcFresh = 0;
+#endif
+#if LOCAL_TIME
+    tk_get(&RTC.milisecReg);    /* time kept by Timer1 */
+#endif
+#if ALIGN
+    rolled = RTC.secondsReg != lastSec;
+    if(fresh)
+        sched_at(tRtc, align_read(rtcReadTick, RTC.milisecReg, rolled));
+#endif
+    if(RTC.secondsReg != lastSec) {     /* wall time for the duty counter */
+        lastSec = RTC.secondsReg;
+        power_second();
+    }
+    if(!power_lcd_on())         /* nothing to see */
+        return;
+#if ALIGN
+    if(fresh && !rolled && nextFrame)
+        return;                 /* second not there yet */
+    if(fresh && nextFrame && RTC.secondsReg == nextSec) {
+        PROF_BEGIN(PROF_DISPLAY);
+        lcd_fb_flush();         /* the prepared frame */
+        PROF_END(PROF_DISPLAY);
+    } else {
+        display();
+    }
+    prepareNext();
+#else
+    display();
+#endif
+    if(keyPending) {            /* key press reached the screen */
+        uint16_t lat = sched_ticks() - keyTime;
+        keyPending = 0;
+        if(lat > latencyMax)
+            latencyMax = lat;
+    }
+}
+
+/*
+ * Show value of the position being set, blinking cursor stays on it
+ */
+void showDigit(uint8_t pos, uint8_t value) {
+    lcd_fb_goto(pos);
+    lcd_fb_putchar('0' + value);
+    lcd_fb_flush();
     lcd_goto(pos);
-    while(1) {
-        DelayMs(100);
-        switch(pressedButton()) {
-            case 0 :
-                *valueReg = (*valueReg + 1) % (max + 1);
-                lcd_goto(pos);
-                lcd_putchar('0' + *valueReg);
-                break;
-            case 1 :
-                return;
-            default :
-                break;
-        }
+}
+
+/*
+ * Print unsigned number into the frame buffer without leading zeros
+ */
+void fbPutu(uint16_t n) {
+    uint16_t d = 10000;
+
+    while(d > 1 && n < d)
+        d /= 10;
+    for(; d; d /= 10)
+        lcd_fb_putchar('0' + (n / d) % 10);
+}
+
+/*
+ * Debug page: active CPU time and the worst key to screen latency
+ */
+void showStats() {
+    uint16_t duty = power_duty();
+
+    lcd_fb_clear();
+    lcd_fb_goto(0);
+    lcd_fb_puts("duty ");
+    fbPutu(duty / 10);
+    lcd_fb_putchar('.');
+    lcd_fb_putchar('0' + duty % 10);
+    lcd_fb_putchar('%');
+    lcd_fb_goto(LCD_LINE2);
+    lcd_fb_puts("lat ");
+    fbPutu(latencyMax);
+    lcd_fb_puts(" ms");
+    lcd_fb_flush();
+}
+
+#if RTC_RAM
+/*
+ * Print a BCD register into the frame buffer
+ */
+void fbPutBcd(uint8_t v) {
+    lcd_fb_putchar('0' + (v >> 4));
+    lcd_fb_putchar('0' + (v & 0x0f));
+}
+
+/*
+ * Debug page: event i of the log in the RTC RAM, 0 = newest
+ */
+void showEvent(uint8_t i) {
+    rtc_event_t e;
+
+    lcd_fb_clear();
+    lcd_fb_goto(0);
+    if(rtc_ram_log_get(i, &e)) {
+        lcd_fb_puts(e.type == RTC_EV_SET ? "set  " : "stop ");
+        fbPutBcd(e.hours & 0x3f);
+        lcd_fb_putchar(':');
+        fbPutBcd(e.minutes);
+        lcd_fb_putchar(':');
+        fbPutBcd(e.seconds);
+        lcd_fb_goto(LCD_LINE2);
+        lcd_fb_putchar('-');
+        fbPutu(i);
+        lcd_fb_puts(" of ");
+        fbPutu(rtc_ram_log_count());
+    } else {
+        lcd_fb_puts("no events");
     }
+    lcd_fb_flush();
 }
+#endif
 
+#if LOCAL_TIME
 /*
- * Function for setting time defined by user.
- * BTN2 to start function (only in regular time mode!), control described in
- * function readAndSet.
- */
-void clockSetup() {
-    if(!mode) {
-        int pos = 0;
-        while(pos < 8) {
-            switch(pos) {
-                case 0: 
-                    readAndSet(pos, &hoursT, 2);
-                    break;
-                case 1: 
-                    if(hoursT == 2) readAndSet(pos, &hoursD, 3);
-                    else            readAndSet(pos, &hoursD, 9);
-                    break;
-                case 3:
-                    readAndSet(pos, &minutesT, 5);
-                    break;
-                case 4:
-                    readAndSet(pos, &minutesD, 9);
-                    break;
-                case 6:
-                    readAndSet(pos, &secondsT, 5);
-                    break;    
-                case 7:
-                    readAndSet(pos, &secondsD, 9);
-                    break;
-                default:
-                    break;
-            }
-            pos++;
-        }
-        RTC.secondsReg = (secondsT << 4) | (secondsD);
-        RTC.minutesReg = (minutesT << 4) | (minutesD);
-        RTC.hoursReg   = (hoursT   << 4) | (hoursD);
-        setTime();
-        DelayMs(100); 
+ * Debug page: latest drift of the Timer1 time against the RTC
+ */
+void showDrift() {
+    tk_drift_t d;
+    uint16_t a;
+
+    lcd_fb_clear();
+    lcd_fb_goto(0);
+    lcd_fb_puts("drift ");
+    if(tk_log_get(0, &d)) {
+        lcd_fb_putchar(d.drift < 0 ? '-' : '+');
+        a = d.drift < 0 ? -d.drift : d.drift;
+        fbPutu(a / 100);
+        lcd_fb_putchar('.');
+        lcd_fb_putchar('0' + a / 10 % 10);
+        lcd_fb_putchar('0' + a % 10);
+        lcd_fb_puts(" s");
+        lcd_fb_goto(LCD_LINE2);
+        lcd_fb_puts("in ");
+        fbPutu(d.minutes);
+        lcd_fb_puts(" min");
     } else {
-        lcd_clear();
-        lcd_goto(0);
-        lcd_puts("Cannot set time");
-        lcd_goto(40);
-        lcd_puts("in binary mode");
-        DelayMs(2000); 
+        lcd_fb_puts("--");
     }
+    lcd_fb_flush();
 }
+#endif
 
+#if PROFILE
 /*
- * Temporary clock stop.
- * BTN1 to stop time, after pressing BTN1 again time continues from when 
- * it stopped.
+ * Debug page: one probe of the profiler, times in us
+ *      disp n1234
+ *      12/34/567us         (min/avg/max)
  */
-void clockStop() {
-    while(pressedButton() != 0);
-    setTime();
+void showProf(uint8_t p) {
+    prof_t e;
+
+    lcd_fb_clear();
+    lcd_fb_goto(0);
+    lcd_fb_puts(prof_name(p));
+    lcd_fb_puts(" n");
+    if(prof_get(p, &e)) {
+        fbPutu(e.count);
+        lcd_fb_goto(LCD_LINE2);
+        fbPutu(prof_us(e.min));
+        lcd_fb_putchar('/');
+        fbPutu(prof_us(e.total / e.count));
+        lcd_fb_putchar('/');
+        fbPutu(prof_us(e.max));
+        lcd_fb_puts("us");
+    } else {
+        lcd_fb_putchar('0');
+    }
+    lcd_fb_flush();
 }
+#endif
 
-void main() {    
-    /* PIC, RTC and LCD initialization */
-    init();
-    /* start the clock */
-    setTime();
-    RTC.controlReg = 0;
-    setTime();
-    
+/*
+ * Take the next key press for the UI (0 = BTN1 .. 2 = BTN3, 3 = BTN3 held),
+ * -1 if there is none. Auto-repeat of a held key counts as a press if
+ * repeat is set. BTN3 acts on release so that its long press can open the
+ * debug page. A press which only switches the sleeping LCD on is dropped.
+ */
+int8_t takeKey(uint8_t repeat) {
+    static uint8_t held = 0;    /* BTN3 press already used */
+    btn_event_t e;
+    int8_t k;
+
+    PROF_BEGIN(PROF_KEYS);
+    while(btn_get(&e)) {
+        k = -1;
+        if(e.type == BTN_PRESS && power_activity()) {
+            if(e.key == 2)
+                held = 1;       /* nor its long press or release */
+        } else if(e.key == 2) {
+            if(e.type == BTN_PRESS)
+                held = 0;
+            else if(e.type == BTN_LONG && !held) {
+                held = 1;
+                k = 3;
+            } else if(e.type == BTN_RELEASE && !held)
+                k = 2;
+        } else if(e.type == BTN_PRESS || (repeat && e.type == BTN_REPEAT)) {
+            k = e.key;
+        }
+        if(k >= 0) {
+            keyTime = e.time;
+            keyPending = 1;
+            PROF_END(PROF_KEYS);
+            return k;
+        }
+    }
+    PROF_END(PROF_KEYS);
+    return -1;
+}
+
+/*
+ * UI task (protothread), runs on button events and its own timeouts.
+ *
+ * BTN1: temporary clock stop, after pressing BTN1 again time continues
+ *       from when it stopped.
+ * BTN2: setting of time (only in regular time mode!), BTN1 to change value
+ *       of the position (hold to repeat), BTN2 to confirm and move to next
+ *       position.
+ * BTN3: switch between regular and binary mode, hold it for the debug
+ *       page (duty cycle, latency) until the next key. With RTC_RAM
+ *       BTN1 moves on to the event log, newest first, BTN1 shows the
+ *       next older event. With LOCAL_TIME
+ *       BTN3 moves on to the drift page, where BTN1 resyncs with the RTC.
+ *       With PROFILE BTN2 moves on to the profiler pages: BTN2 shows the
+ *       next probe, BTN1 clears the counters.
+ */
+void taskUi() {
+    static pt_t pt = 0;
+    static int8_t k;
+    static uint8_t pos, max;
+    static uint8_t *valueReg;
+    static tick_t until;
+
+    PT_BEGIN(&pt);
     while(1) {
-        getTime();
-        display();
-        switch(pressedButton()) {
-            case 0 : /* BTN1 */
-                clockStop();
-                break;
-            case 1 : /* BTN2 */
-                clockSetup();
-                break;
-            case 2 : /* BTN3 */
-                mode = ~mode;
-                break;
-            default :
-                break;
+        PT_WAIT_UNTIL(&pt, (k = takeKey(0)) >= 0);
+
+        if(k == 0) {            /* BTN1 */
+            uiBusy = 1;         /* screen keeps the stopped time */
+            logEvent(RTC_EV_STOP);
+            PT_WAIT_UNTIL(&pt, takeKey(0) == 0);
+            setTime();
+            logEvent(RTC_EV_SET);
+            uiBusy = 0;
+        } else if(k == 1) {     /* BTN2 */
+            uiBusy = 1;
+            if(!mode) {
+                for(pos = 0; pos < 8; pos++) {
+                    if(pos == 0)      { valueReg = &hoursT;   max = 2; }
+                    else if(pos == 1) { valueReg = &hoursD;   max = (hoursT == 2) ? 3 : 9; }
+                    else if(pos == 3) { valueReg = &minutesT; max = 5; }
+                    else if(pos == 4) { valueReg = &minutesD; max = 9; }
+                    else if(pos == 6) { valueReg = &secondsT; max = 5; }
+                    else if(pos == 7) { valueReg = &secondsD; max = 9; }
+                    else continue;
+                    lcd_goto(pos);
+                    while(1) {
+                        PT_WAIT_UNTIL(&pt, (k = takeKey(1)) >= 0);
+                        if(k == 1)
+                            break;
+                        if(k == 0) {
+                            *valueReg = (*valueReg + 1) % (max + 1);
+                            showDigit(pos, *valueReg);
+                        }
+                    }
+                }
+                RTC.secondsReg = (secondsT << 4) | (secondsD);
+                RTC.minutesReg = (minutesT << 4) | (minutesD);
+                RTC.hoursReg   = (hoursT   << 4) | (hoursD);
+                setTime();
+                logEvent(RTC_EV_SET);
+#if SETTINGS
+                settings.hours   = RTC.hoursReg;
+                settings.minutes = RTC.minutesReg;
+                settings_save(&settings);
+#endif
+            } else {
+                lcd_fb_clear();
+                lcd_fb_goto(0);
+                lcd_fb_puts("Cannot set time");
+                lcd_fb_goto(40);
+                lcd_fb_puts("in binary mode");
+                lcd_fb_flush();
+                until = sched_ticks() + 2000;
+                sched_at(tUi, 2000);
+                PT_WAIT_UNTIL(&pt, sched_reached(until));
+                while(takeKey(1) >= 0);     /* drop presses during the message */
+            }
+            uiBusy = 0;
+        } else if(k == 2) {     /* BTN3 */
+            mode = ~mode;
+            saveMode();
+        } else if(k == 3) {     /* BTN3 held */
+            uiBusy = 1;
+            showStats();
+            PT_WAIT_UNTIL(&pt, (k = takeKey(0)) >= 0);
+#if RTC_RAM
+            if(k == 0) {
+                for(pos = 0; ; ) {
+                    showEvent(pos);
+                    PT_WAIT_UNTIL(&pt, (k = takeKey(0)) >= 0);
+                    if(k != 0 || ++pos >= rtc_ram_log_count())
+                        break;
+                }
+                k = -1;         /* no other page */
+            }
+#endif
+#if LOCAL_TIME
+            if(k == 2) {
+                showDrift();
+                PT_WAIT_UNTIL(&pt, (k = takeKey(0)) >= 0);
+                if(k == 0)
+                    tk_resync();
+            }
+#endif
+#if PROFILE
+            if(k == 1) {
+                prof_dump();    /* copy of the table on the serial port */
+                for(pos = 0; pos < PROF_PROBES; ) {
+                    showProf(pos);
+                    PT_WAIT_UNTIL(&pt, (k = takeKey(0)) >= 0);
+                    if(k == 0)
+                        prof_reset();
+                    else if(k == 1)
+                        pos++;
+                    else
+                        break;
+                }
+            }
+#endif
+            uiBusy = 0;
         }
+        sched_trigger(tDisplay);
     }
+    PT_END(&pt);
+}
+
+void main() {    
+    /* PIC, RTC and LCD initialization */
+    init();
+#if SETTINGS
+    loadSettings();
+#endif
+#if BENCH_LCD
+    bench_lcd();
+#endif
+#if BENCH_EEPROM
+    bench_eeprom();
+#endif
+    if(rtcStart())
+        display();              /* first frame without waiting for a read */
+
+    /*
+     * RTC is read once per second on its interrupt or polled, or only for
+     * the resync of the local time
+     */
+#if RTC_EVENT_DRIVEN || LOCAL_TIME || ALIGN
+    tRtc     = sched_add(taskRtc, 0, 0);
+#else
+    tRtc     = sched_add(taskRtc, 0, RTC_POLL_MS);
+#endif
+    tDisplay = sched_add(taskDisplay, 0, 0);
+    tUi      = sched_add(taskUi, 0, 0);
+    btn_init(tUi);
+#if SETTINGS
+    tSettings = sched_add(settings_task, 0, 0);
+    settings_init(tSettings);
+#endif
+#if LOCAL_TIME
+    tk_init(tDisplay, tRtc);    /* display every second, resync */
+#endif
+    sched_run();
 }